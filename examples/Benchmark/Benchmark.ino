@@ -0,0 +1,305 @@
+/* This example measures how long the time-critical functions of
+the Zumo32U4 library take to run on the robot itself, and how
+much stack space each of them uses.
+
+The results are printed to the serial monitor as a table of
+comma-separated values, with one row per function:
+
+  name,calls,us_per_call,cycles_per_call,stack_bytes
+
+Each function is called many times in a row and the average time
+per call is reported, so the 4 us resolution of micros() does not
+limit the precision of the results.  Stack usage is measured by
+filling the unused part of the stack with a known pattern before
+running a function and then checking how much of the pattern got
+overwritten.
+
+To compare two versions of the library, run this sketch with each
+version and compare the tables.  The results depend on the
+surface under the line sensors and on objects near the proximity
+sensors, so keep the robot in the same place for both runs.
+
+This example uses line sensors 1, 3, and 5 and all three
+proximity sensors, so the jumpers on the front sensor array must
+connect pin 4 to RGT and pin 20 to LFT (the default).
+
+After the main table, the sketch prints a second table that
+compares the line sensor oversampling settings (see
+QTRSensorsRC::setOversampling()):
+
+  name,us_per_call,noise_us
+
+The noise is the average difference between consecutive raw
+readings of the same sensor, so it is only meaningful if the robot
+is not moving.
+
+The rows for the floating-point atan2() and sqrt() functions show
+the cost of finding the direction and magnitude of an impact the
+way the SumoCollisionDetect example used to, for comparison with
+Zumo32U4Trig::arctangent() and Zumo32U4Trig::magnitude().
+
+The time spent in the encoder interrupt service routines is not
+measured by this sketch. */
+
+#include <Wire.h>
+#include <Zumo32U4.h>
+
+Zumo32U4LineSensors lineSensors;
+Zumo32U4ProximitySensors proxSensors;
+Zumo32U4Encoders encoders;
+Zumo32U4IMU imu;
+Zumo32U4Odometry odometry;
+Zumo32U4StallDetector<> stallDetector;
+Zumo32U4CollisionDetector<> collisionDetector;
+Zumo32U4TiltMonitor tiltMonitor;
+Zumo32U4Compass compass;
+
+// The OLED version of the Zumo 32U4 uses Zumo32U4OLEDCore to send
+// bytes to its display.  Sending bytes like this to the LCD
+// version is harmless, but the results will not mean anything.
+Zumo32U4OLEDCore oledCore;
+
+uint16_t lineSensorValues[3];
+
+bool imuFound;
+
+// Results are stored here so that the compiler cannot optimize
+// away the calls that produce them.
+volatile int16_t trigResult;
+volatile bool collisionResult;
+volatile uint8_t tiltResult;
+volatile float floatResult;
+
+extern char __heap_start;
+extern char * __brkval;
+
+const uint8_t stackPattern = 0xA5;
+
+// Returns the lowest address that the stack could grow into
+// without hitting the heap.
+static uint8_t * stackLimit()
+{
+  return (uint8_t *)(__brkval == 0 ? &__heap_start : __brkval);
+}
+
+// Fills the unused part of the stack with stackPattern.  Returns
+// the address of the top of the painted region.
+static uint8_t * paintStack()
+{
+  uint8_t marker;
+  uint8_t * top = &marker - 32;
+  for (uint8_t * p = stackLimit() + 16; p < top; p++)
+  {
+    *p = stackPattern;
+  }
+  return top;
+}
+
+// Returns the number of bytes below top that have been
+// overwritten since paintStack() was called.
+static uint16_t stackUsed(uint8_t * top)
+{
+  uint8_t * p = stackLimit() + 16;
+  while (p < top && *p == stackPattern) { p++; }
+  return top - p;
+}
+
+static void report(const __FlashStringHelper * name,
+  uint16_t calls, uint32_t totalUs, uint16_t stackBytes)
+{
+  // Report times in hundredths of a microsecond so we don't need
+  // floating point formatting.
+  uint32_t usx100 = totalUs * 100 / calls;
+  uint32_t cycles = totalUs * (F_CPU / 1000000) / calls;
+
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(calls);
+  Serial.print(',');
+  Serial.print(usx100 / 100);
+  Serial.print('.');
+  if (usx100 % 100 < 10) { Serial.print('0'); }
+  Serial.print(usx100 % 100);
+  Serial.print(',');
+  Serial.print(cycles);
+  Serial.print(',');
+  Serial.println(stackBytes);
+}
+
+// Runs the code in the body the specified number of times and
+// reports the results.
+#define BENCHMARK(name, calls, body) \
+  { \
+    uint8_t * top = paintStack(); \
+    uint32_t start = micros(); \
+    for (uint16_t i = 0; i < (calls); i++) { body; } \
+    uint32_t totalUs = micros() - start; \
+    report(F(name), (calls), totalUs, stackUsed(top)); \
+  }
+
+// Takes raw line sensor readings with the current oversampling
+// setting and prints the time per reading and the average
+// difference between consecutive readings of the same sensor.
+void reportOversampling(const __FlashStringHelper * name)
+{
+  const uint8_t reads = 50;
+  uint16_t previous[3];
+  uint32_t totalDifference = 0;
+
+  lineSensors.read(previous);
+  uint32_t start = micros();
+  for (uint8_t i = 0; i < reads; i++)
+  {
+    lineSensors.read(lineSensorValues);
+    for (uint8_t j = 0; j < 3; j++)
+    {
+      totalDifference += abs((int16_t)(lineSensorValues[j] - previous[j]));
+      previous[j] = lineSensorValues[j];
+    }
+  }
+  uint32_t totalUs = micros() - start;
+
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(totalUs / reads);
+  Serial.print(',');
+  Serial.println(totalDifference / (reads * 3));
+}
+
+void runOversamplingBenchmarks()
+{
+  Serial.println(F("name,us_per_call,noise_us"));
+
+  lineSensors.setOversampling(1);
+  reportOversampling(F("1 sample"));
+
+  lineSensors.setOversampling(3, QTR_FILTER_MEDIAN);
+  reportOversampling(F("3 samples median"));
+
+  lineSensors.setOversampling(5, QTR_FILTER_MEDIAN);
+  reportOversampling(F("5 samples median"));
+
+  lineSensors.setOversampling(5, QTR_FILTER_TRIMMED_MEAN);
+  reportOversampling(F("5 samples trimmed mean"));
+
+  lineSensors.setOversampling(5, QTR_FILTER_MEDIAN, true);
+  reportOversampling(F("5 samples median pipelined"));
+
+  lineSensors.setOversampling(1);
+
+  Serial.println();
+}
+
+void runBenchmarks()
+{
+  Serial.println(F("name,calls,us_per_call,cycles_per_call,stack_bytes"));
+
+  BENCHMARK("QTRSensorsRC::read", 100,
+    lineSensors.read(lineSensorValues));
+
+  BENCHMARK("QTRSensors::readCalibrated", 100,
+    lineSensors.readCalibrated(lineSensorValues));
+
+  BENCHMARK("QTRSensors::readLine", 100,
+    lineSensors.readLine(lineSensorValues));
+
+  BENCHMARK("Zumo32U4LineSensors::readLinePosition", 100,
+    lineSensors.readLinePosition(lineSensorValues));
+
+  BENCHMARK("Zumo32U4LineSensors::readLinePosition interpolated", 100,
+    lineSensors.readLinePosition(lineSensorValues, QTR_EMITTERS_ON,
+    false, true));
+
+  BENCHMARK("Zumo32U4ProximitySensors::read", 20,
+    proxSensors.read());
+
+  BENCHMARK("Zumo32U4Encoders::getCountsLeft", 1000,
+    encoders.getCountsLeft());
+
+  BENCHMARK("Zumo32U4Encoders::getCountsAndResetRight", 1000,
+    encoders.getCountsAndResetRight());
+
+  BENCHMARK("Zumo32U4Odometry::update", 1000,
+    odometry.update(12, 14));
+
+  BENCHMARK("Zumo32U4StallDetector::update", 1000,
+    stallDetector.update());
+
+  BENCHMARK("Zumo32U4Trig::sine", 1000,
+    trigResult = Zumo32U4Trig::sine(i * 97));
+
+  BENCHMARK("Zumo32U4Trig::arctangent", 1000,
+    trigResult = Zumo32U4Trig::arctangent(i * 31, 5000 - i * 11));
+
+  BENCHMARK("atan2 (float)", 1000,
+    floatResult = atan2((float)(i * 31), (float)(5000 - i * 11))
+    * 180 / M_PI);
+
+  BENCHMARK("Zumo32U4Trig::magnitude", 1000,
+    trigResult = Zumo32U4Trig::magnitude(i * 31, 5000 - i * 11));
+
+  BENCHMARK("sqrt (float)", 1000,
+    floatResult = sqrt((float)((int32_t)(i * 31) * (i * 31)
+    + (int32_t)(5000 - i * 11) * (5000 - i * 11))));
+
+  BENCHMARK("Zumo32U4CollisionDetector::addReading", 1000,
+    collisionResult = collisionDetector.addReading(i * 7, -i * 5));
+
+  BENCHMARK("Zumo32U4TiltMonitor::addAccReading", 1000,
+    tiltResult = tiltMonitor.addAccReading(i * 3, -i * 2, 16384 - i * 4));
+
+  BENCHMARK("Zumo32U4TiltMonitor::addGyroReading", 1000,
+    tiltResult = tiltMonitor.addGyroReading(i * 3));
+
+  BENCHMARK("Zumo32U4Compass::heading", 1000,
+    trigResult = compass.heading(2500 - i, i * 2, -4300,
+    i, -i, 16384 - i));
+
+  if (imuFound)
+  {
+    BENCHMARK("Zumo32U4IMU::readAcc", 100, imu.readAcc());
+    BENCHMARK("Zumo32U4IMU::readGyro", 100, imu.readGyro());
+    BENCHMARK("Zumo32U4IMU::read", 100, imu.read());
+    BENCHMARK("Zumo32U4CollisionDetector::update", 100,
+      collisionResult = collisionDetector.update(imu));
+  }
+
+  oledCore.initPins();
+  oledCore.sh1106TransferStart();
+  oledCore.sh1106DataMode();
+  BENCHMARK("Zumo32U4OLEDCore::sh1106Write", 1000,
+    oledCore.sh1106Write((uint8_t)i));
+  oledCore.sh1106TransferEnd();
+
+  Serial.println();
+}
+
+void setup()
+{
+  lineSensors.initThreeSensors();
+  proxSensors.initThreeSensors();
+
+  // Give the line sensors a simple calibration so that
+  // readCalibrated() and readLine() do real work.
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    lineSensors.calibrate();
+  }
+
+  Wire.begin();
+  imuFound = imu.init();
+  if (imuFound)
+  {
+    imu.enableDefault();
+  }
+
+  // Wait for the serial monitor to be opened.
+  while (!Serial) {}
+}
+
+void loop()
+{
+  runBenchmarks();
+  runOversamplingBenchmarks();
+  delay(5000);
+}
@@ -1,6 +1,8 @@
 /** This example uses the Zumo's line sensors to detect the white
 border around a sumo ring.  When the border is detected, it
-backs up and turns. */
+brakes, backs up, and turns.  The braking uses Zumo32U4Brake,
+which drives the motors against the motion measured by the
+encoders so that the robot stops sliding sooner. */
 
 #include <Wire.h>
 #include <Zumo32U4.h>
@@ -24,6 +26,7 @@ Zumo32U4OLED display;
 Zumo32U4ButtonA buttonA;
 Zumo32U4Buzzer buzzer;
 Zumo32U4Motors motors;
+Zumo32U4Brake brake;
 Zumo32U4LineSensors lineSensors;
 
 #define NUM_SENSORS 3
@@ -51,6 +54,16 @@ void waitForButtonAndCountDown()
   delay(1000);
 }
 
+// Stops the robot with active braking and then backs up.
+void brakeAndReverse()
+{
+  brake.brakeThenReverse(-REVERSE_SPEED, REVERSE_DURATION);
+  while (!brake.isDone())
+  {
+    brake.update();
+  }
+}
+
 void setup()
 {
   // Uncomment if necessary to correct motor directions:
@@ -77,20 +90,18 @@ void loop()
 
   if (lineSensorValues[0] < QTR_THRESHOLD)
   {
-    // If leftmost sensor detects line, reverse and turn to the
-    // right.
-    motors.setSpeeds(-REVERSE_SPEED, -REVERSE_SPEED);
-    delay(REVERSE_DURATION);
+    // If leftmost sensor detects line, stop, reverse, and turn
+    // to the right.
+    brakeAndReverse();
     motors.setSpeeds(TURN_SPEED, -TURN_SPEED);
     delay(TURN_DURATION);
     motors.setSpeeds(FORWARD_SPEED, FORWARD_SPEED);
   }
   else if (lineSensorValues[NUM_SENSORS - 1] < QTR_THRESHOLD)
   {
-    // If rightmost sensor detects line, reverse and turn to the
-    // left.
-    motors.setSpeeds(-REVERSE_SPEED, -REVERSE_SPEED);
-    delay(REVERSE_DURATION);
+    // If rightmost sensor detects line, stop, reverse, and turn
+    // to the left.
+    brakeAndReverse();
     motors.setSpeeds(-TURN_SPEED, TURN_SPEED);
     delay(TURN_DURATION);
     motors.setSpeeds(FORWARD_SPEED, FORWARD_SPEED);
@@ -0,0 +1,111 @@
+/* This example measures how far the Zumo slides after it stops
+driving, with and without active braking from Zumo32U4Brake.
+
+Each time you press button A, the robot drives forward twice.  The
+first time, it stops by setting the motor speeds to 0, which
+brakes the motors passively.  The second time, it stops with
+Zumo32U4Brake::brake(), which drives the motors against the
+motion measured by the encoders.  For each stop, it prints a row
+to the serial monitor:
+
+  method,speed,stopping_counts,stopping_ms
+
+stopping_counts is how far the robot traveled after it started
+stopping, in encoder counts (about 7.4 counts per millimeter with
+75:1 motors), and stopping_ms is how long it took to stop.
+
+Place the robot on a flat surface with about a meter of clear
+space in front of it, open the serial monitor, and press A. */
+
+#include <Wire.h>
+#include <Zumo32U4.h>
+
+// The speed to drive at before stopping.
+const int16_t driveSpeed = 400;
+
+// How long to drive before stopping, in milliseconds.
+const uint16_t driveTime = 400;
+
+Zumo32U4Motors motors;
+Zumo32U4Encoders encoders;
+Zumo32U4ButtonA buttonA;
+Zumo32U4Brake brake;
+
+// Returns the average of the encoder counts.
+int16_t readPosition()
+{
+  return (encoders.getCountsLeft() + encoders.getCountsRight()) / 2;
+}
+
+void printResult(const __FlashStringHelper * method,
+  int16_t counts, uint16_t ms)
+{
+  Serial.print(method);
+  Serial.print(',');
+  Serial.print(driveSpeed);
+  Serial.print(',');
+  Serial.print(counts);
+  Serial.print(',');
+  Serial.println(ms);
+}
+
+void driveForward()
+{
+  motors.setSpeeds(driveSpeed, driveSpeed);
+  delay(driveTime);
+}
+
+// Waits until the encoders have not changed for 20 ms, while also
+// running the brake if it is on, then prints how far the robot
+// traveled and how long it took to stop.  Both methods are measured
+// this way so that the brake's own test for stopping does not affect
+// the results.
+void measureStop(const __FlashStringHelper * method)
+{
+  int16_t start = readPosition();
+  uint16_t startMs = millis();
+  int16_t last = start;
+  uint16_t lastChangeMs = startMs;
+  while (!brake.isDone() || (uint16_t)(millis() - lastChangeMs) < 20)
+  {
+    brake.update();
+    int16_t position = readPosition();
+    if (position != last)
+    {
+      last = position;
+      lastChangeMs = millis();
+    }
+  }
+
+  printResult(method, last - start, lastChangeMs - startMs);
+}
+
+void testPassive()
+{
+  driveForward();
+  motors.setSpeeds(0, 0);
+  measureStop(F("passive"));
+}
+
+void testActive()
+{
+  driveForward();
+  brake.brake();
+  measureStop(F("active"));
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+  buttonA.waitForButton();
+  delay(1000);
+
+  Serial.println(F("method,speed,stopping_counts,stopping_ms"));
+  testPassive();
+  delay(500);
+  testActive();
+  Serial.println();
+}
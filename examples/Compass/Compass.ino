@@ -0,0 +1,111 @@
+/* This example uses Zumo32U4Compass to calibrate the magnetometer
+and show a tilt-compensated compass heading.
+
+Press button A to calibrate: the robot spins in place for 5
+seconds, so put it on a level surface with some space around it,
+away from magnets and large pieces of steel.  The calibration is
+saved in EEPROM, so it is used again the next time the sketch
+starts, until you calibrate again.
+
+The display shows the compass bearing of the front of the robot
+in degrees, measured clockwise from magnetic north, and the same
+number is printed to the serial monitor along with the raw
+magnetometer readings. */
+
+#include <Wire.h>
+#include <EEPROM.h>
+#include <Zumo32U4.h>
+
+// Change next line to this if you are using the older Zumo 32U4
+// with a black and green LCD display:
+// Zumo32U4LCD display;
+Zumo32U4OLED display;
+
+Zumo32U4IMU imu;
+Zumo32U4ButtonA buttonA;
+Zumo32U4Compass compass;
+
+// The calibration is stored in EEPROM after this byte, which
+// tells whether a calibration has been saved.
+const uint16_t eepromAddress = 0;
+const uint8_t eepromMarker = 0xC5;
+
+void loadCalibration()
+{
+  if (EEPROM.read(eepromAddress) != eepromMarker) { return; }
+  Zumo32U4Compass::Calibration calibration;
+  EEPROM.get(eepromAddress + 1, calibration);
+  compass.setCalibration(calibration);
+}
+
+void calibrate()
+{
+  display.clear();
+  display.print(F("Cal..."));
+  delay(1000);
+
+  if (compass.calibrate(imu))
+  {
+    EEPROM.put(eepromAddress + 1, compass.getCalibration());
+    EEPROM.write(eepromAddress, eepromMarker);
+  }
+  else
+  {
+    display.clear();
+    display.print(F("Cal fail"));
+    delay(1000);
+  }
+
+  const Zumo32U4Compass::Calibration & c = compass.getCalibration();
+  Serial.print(F("offsets "));
+  Serial.print(c.offsetX);
+  Serial.print(' ');
+  Serial.print(c.offsetY);
+  Serial.print(' ');
+  Serial.print(c.offsetZ);
+  Serial.print(F(" scales "));
+  Serial.print(c.scaleX);
+  Serial.print(' ');
+  Serial.print(c.scaleY);
+  Serial.print(' ');
+  Serial.println(c.scaleZ);
+  display.clear();
+}
+
+void setup()
+{
+  Wire.begin();
+  imu.init();
+  imu.enableDefault();
+  loadCalibration();
+}
+
+void loop()
+{
+  if (buttonA.getSingleDebouncedPress())
+  {
+    calibrate();
+  }
+
+  imu.readAcc();
+  imu.readMag();
+
+  // A bearing is clockwise, so it is the negative of the
+  // heading.
+  uint16_t bearing = -compass.heading(imu);
+  uint16_t degrees = (uint32_t)bearing * 360 / 65536;
+
+  display.gotoXY(0, 0);
+  display.print(degrees);
+  display.print(F("   "));
+
+  Serial.print(imu.m.x);
+  Serial.print(' ');
+  Serial.print(imu.m.y);
+  Serial.print(' ');
+  Serial.print(imu.m.z);
+  Serial.print(' ');
+  Serial.println(degrees);
+
+  delay(100);
+}
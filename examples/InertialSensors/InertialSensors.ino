@@ -15,7 +15,8 @@ significant bit).  A raw reading of 10285 would correspond to
 90 dps.
 
 The magnetometer readings are more difficult to interpret and
-will usually require calibration. */
+will usually require calibration.  The Compass example shows how
+to calibrate them with Zumo32U4Compass. */
 
 #include <Wire.h>
 #include <Zumo32U4.h>
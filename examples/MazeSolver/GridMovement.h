@@ -55,6 +55,11 @@ const int32_t gyroAngle45 = 0x20000000;
 
 uint16_t lineSensorValues[numSensors];
 
+// Classifies each set of line sensor readings, so we can check
+// for lines, intersections, and dark spots without looking at
+// the readings again.
+Zumo32U4LineFeatures lineFeatures(sensorThreshold, sensorThresholdDark);
+
 
 // Sets up special characters for the display so that we can show
 // bar graphs.
@@ -80,25 +85,20 @@ void printBar(uint8_t height)
 }
 
 // Takes calibrated readings of the lines sensors and stores them
-// in lineSensorValues.  Also returns an estimation of the line
-// position.
+// in lineSensorValues, and classifies them with lineFeatures.
+// Also returns an estimation of the line position.
 uint16_t readSensors()
 {
-  return lineSensors.readLine(lineSensorValues);
+  uint16_t position = lineSensors.readLine(lineSensorValues);
+  lineFeatures.update(lineSensorValues, numSensors);
+  return position;
 }
 
 // Returns true if the sensor is seeing a line.
 // Make sure to call readSensors() before calling this.
 bool aboveLine(uint8_t sensorIndex)
 {
-  return lineSensorValues[sensorIndex] > sensorThreshold;
-}
-
-// Returns true if the sensor is seeing a lot of darkness.
-// Make sure to call readSensors() before calling this.
-bool aboveLineDark(uint8_t sensorIndex)
-{
-  return lineSensorValues[sensorIndex] > sensorThresholdDark;
+  return lineFeatures.isOnLine(sensorIndex);
 }
 
 // Checks to see if we are over a dark spot, like the ones used
@@ -107,7 +107,7 @@ bool aboveLineDark(uint8_t sensorIndex)
 // Make sure to call readSensors() before calling this.
 bool aboveDarkSpot()
 {
-  return aboveLineDark(1) && aboveLineDark(2) && aboveLineDark(3);
+  return lineFeatures.isDarkSpot();
 }
 
 // Turns according to the parameter dir, which should be 'L'
@@ -215,14 +215,14 @@ void followSegment()
     // after a turn, and if one of the far sensors is over the
     // line then it could cause a false intersection detection.
 
-    if(!aboveLine(0) && !aboveLine(1) && !aboveLine(2) && !aboveLine(3) && !aboveLine(4))
+    if(!lineFeatures.lineVisible())
     {
       // There is no line visible ahead, and we didn't see any
       // intersection.  Must be a dead end.
       break;
     }
 
-    if(aboveLine(0) || aboveLine(4))
+    if(lineFeatures.hasLeft() || lineFeatures.hasRight())
     {
       // Found an intersection or a dark spot.
       break;
@@ -259,11 +259,11 @@ void driveToIntersectionCenter(bool * foundLeft, bool * foundStraight, bool * fo
   for(uint16_t i = 0; i < intersectionDelay / 2; i++)
   {
     readSensors();
-    if(aboveLine(0))
+    if(lineFeatures.hasLeft())
     {
       *foundLeft = 1;
     }
-    if(aboveLine(4))
+    if(lineFeatures.hasRight())
     {
       *foundRight = 1;
     }
@@ -272,7 +272,7 @@ void driveToIntersectionCenter(bool * foundLeft, bool * foundStraight, bool * fo
   readSensors();
 
   // Check for a straight exit.
-  if(aboveLine(1) || aboveLine(2) || aboveLine(3))
+  if(lineFeatures.hasStraight())
   {
     *foundStraight = 1;
   }
@@ -0,0 +1,112 @@
+/* This example measures how well the motors can be controlled at
+low speeds in each of the PWM modes that
+Zumo32U4Motors::setPwmMode() supports.
+
+For each mode, the sketch slowly raises the duty cycle of both
+motors from zero until both encoders show that the tracks are
+turning, and then slowly lowers it until the tracks stop.  It
+prints one row per mode to the serial monitor:
+
+  mode,max_speed,start_duty,stall_duty,min_counts_per_s
+
+start_duty and stall_duty are the duty cycles, in hundredths of a
+percent, at which the tracks started and stopped turning.
+min_counts_per_s is the lowest steady speed of the slower track
+that was measured before it stopped, in encoder counts per
+second.  A mode with a lower minimum speed and more PWM steps
+below the start duty gives finer control at low speeds.
+
+Place the robot on a flat surface with about 50 cm of clear space
+in front of it, open the serial monitor, and press button A.  The
+robot drives forward slowly during the test. */
+
+#include <Wire.h>
+#include <Zumo32U4.h>
+
+Zumo32U4Motors motors;
+Zumo32U4Encoders encoders;
+Zumo32U4ButtonA buttonA;
+
+// The time spent at each duty cycle, in milliseconds.
+const uint16_t stepTime = 100;
+
+// A track counts as turning if it moves at least this many
+// counts in one step.
+const uint8_t movingCounts = 3;
+
+// Sets both motors to the specified duty cycle (in hundredths of
+// a percent), waits for one step, and returns the smaller of the
+// two encoder counts from that step.
+int16_t runStep(uint16_t duty)
+{
+  uint16_t speed = (uint32_t)duty * motors.getMaxSpeed() / 10000;
+  motors.setSpeeds(speed, speed);
+  encoders.getCountsAndResetLeft();
+  encoders.getCountsAndResetRight();
+  delay(stepTime);
+  int16_t left = encoders.getCountsAndResetLeft();
+  int16_t right = encoders.getCountsAndResetRight();
+  return left < right ? left : right;
+}
+
+void measure(const __FlashStringHelper * name,
+  Zumo32U4Motors::PwmMode mode)
+{
+  motors.setPwmMode(mode);
+
+  // The duty cycle changes by 0.25% at a time, which is one step
+  // in the default mode.
+  uint16_t duty = 0;
+  while (duty < 5000 && runStep(duty) < movingCounts)
+  {
+    duty += 25;
+  }
+  uint16_t startDuty = duty;
+
+  // Go a little higher to make sure that both tracks are moving,
+  // then come back down.
+  duty += 200;
+  runStep(duty);
+  int16_t minCounts = 0;
+  while (duty > 0)
+  {
+    duty -= 25;
+    int16_t counts = runStep(duty);
+    if (counts < movingCounts) { break; }
+    minCounts = counts;
+  }
+  uint16_t stallDuty = duty;
+
+  motors.setSpeeds(0, 0);
+
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(motors.getMaxSpeed());
+  Serial.print(',');
+  Serial.print(startDuty);
+  Serial.print(',');
+  Serial.print(stallDuty);
+  Serial.print(',');
+  Serial.println((int32_t)minCounts * 1000 / stepTime);
+
+  delay(500);
+}
+
+void setup()
+{
+}
+
+void loop()
+{
+  buttonA.waitForButton();
+  delay(1000);
+
+  Serial.println(F("mode,max_speed,start_duty,stall_duty,min_counts_per_s"));
+  measure(F("Ultrasonic"), Zumo32U4Motors::PwmMode::Ultrasonic);
+  measure(F("TenBit"), Zumo32U4Motors::PwmMode::TenBit);
+  measure(F("LowFrequency"), Zumo32U4Motors::PwmMode::LowFrequency);
+  Serial.println();
+
+  // Go back to the default mode.
+  motors.setPwmMode(Zumo32U4Motors::PwmMode::Ultrasonic);
+}
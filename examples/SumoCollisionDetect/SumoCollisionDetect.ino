@@ -5,9 +5,9 @@
  * Front Sensor Array to detect the border of the sumo ring.  It also illustrates the use of the
  * motors, pushbuttons, display, and buzzer.
  *
- * In loop(), the program reads the x and y components of acceleration (ignoring z), and detects a
- * contact when the magnitude of the 3-period average of the x-y vector exceeds an empirically
- * determined XY_ACCELERATION_THRESHOLD.  On contact detection, the forward speed is increased to
+ * In loop(), the program uses Zumo32U4CollisionDetector to read the x and y components of
+ * acceleration (ignoring z), and detects a contact when the magnitude of the 3-period average of
+ * the x-y vector exceeds an empirically determined XY_ACCELERATION_THRESHOLD.  On contact detection, the forward speed is increased to
  * FULL_SPEED from the default SEARCH_SPEED, simulating a "fight or flight" response.
  *
  * The program attempts to detect contact only when the Zumo is going straight.  When it is
@@ -30,11 +30,8 @@
  *   (max), but this feature may be useful to prevent runoffs at the turns if the sumo ring surface
  *   is unusually smooth.
  *
- * - logging of accelerometer output to the serial monitor when LOG_SERIAL is #defined.
- *
- * This example also makes use of the public domain RunningAverage library from the Arduino website;
- * the relevant code has been copied into this .ino file and does not need to be downloaded
- * separately.
+ * - logging of contact events, with the direction and magnitude of each impact, to the serial
+ *   monitor when LOG_SERIAL is #defined.
  */
 
 #include <avr/pgmspace.h>
@@ -89,64 +86,11 @@ const char sound_effect[] PROGMEM = "O4 T100 V15 L4 MS g12>c12>e12>G6>E12 ML>G2"
 
  // Timing
 unsigned long loop_start_time;
-unsigned long last_turn_time;
-unsigned long contact_made_time;
 #define MIN_DELAY_AFTER_TURN          400  // ms = min delay before detecting contact event
 #define MIN_DELAY_BETWEEN_CONTACTS   1000  // ms = min delay between detecting new contact event
 
-// RunningAverage class
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-template <typename T>
-class RunningAverage
-{
-  public:
-    RunningAverage(void);
-    RunningAverage(int);
-    ~RunningAverage();
-    void clear();
-    void addValue(T);
-    T getAverage() const;
-    void fillValue(T, int);
-  protected:
-    int _size;
-    int _cnt;
-    int _idx;
-    T _sum;
-    T * _ar;
-    static T zero;
-};
-
-// Accelerometer Class -- extends the Zumo32U4IMU class to support reading and
-//   averaging the x-y acceleration vectors from the accelerometer
-class Accelerometer : public Zumo32U4IMU
-{
-  typedef struct acc_data_xy
-  {
-    unsigned long timestamp;
-    int x;
-    int y;
-    float dir;
-  } acc_data_xy;
-
-  public:
-    Accelerometer() : ra_x(RA_SIZE), ra_y(RA_SIZE) {};
-    ~Accelerometer() {};
-    void getLogHeader(void);
-    void readAcceleration(unsigned long timestamp);
-    float len_xy() const;
-    float dir_xy() const;
-    int x_avg(void) const;
-    int y_avg(void) const;
-    long ss_xy_avg(void) const;
-    float dir_xy_avg(void) const;
-  private:
-    acc_data_xy last;
-    RunningAverage<int> ra_x;
-    RunningAverage<int> ra_y;
-};
-
-Accelerometer acc;
+Zumo32U4IMU imu;
+Zumo32U4CollisionDetector<RA_SIZE> collisionDetector;
 boolean in_contact;  // set when accelerometer detects contact with opposing robot
 
 // forward declaration
@@ -160,12 +104,11 @@ void setup()
   Wire.begin();
 
   // Initialize accelerometer
-  acc.init();
-  acc.enableDefault();
-
-#ifdef LOG_SERIAL
-  acc.getLogHeader();
-#endif
+  imu.init();
+  imu.enableDefault();
+  imu.configureForCollisionDetection();
+  collisionDetector.setThreshold(XY_ACCELERATION_THRESHOLD);
+  collisionDetector.setMinInterval(MIN_DELAY_BETWEEN_CONTACTS);
 
   randomSeed((unsigned int) millis());
 
@@ -210,8 +153,8 @@ void waitForButtonAndCountDown(bool restarting)
 
   // reset loop variables
   in_contact = false;  // 1 if contact made; 0 if no contact or contact lost
-  contact_made_time = 0;
-  last_turn_time = millis();  // prevents false contact detection on initial acceleration
+  collisionDetector.reset();
+  collisionDetector.ignoreFor(MIN_DELAY_AFTER_TURN);  // prevents false contact detection on initial acceleration
   _forwardSpeed = SearchSpeed;
   full_speed_start_time = 0;
 }
@@ -227,7 +170,6 @@ void loop()
   }
 
   loop_start_time = millis();
-  acc.readAcceleration(loop_start_time);
   sensors.read(sensor_values);
 
   if ((_forwardSpeed == FullSpeed) && (loop_start_time - full_speed_start_time > FULL_SPEED_DURATION_LIMIT))
@@ -247,7 +189,9 @@ void loop()
   }
   else  // otherwise, go straight
   {
-    if (check_for_contact()) on_contact_made();
+    // Only check for contact here, so that an impact is not used up
+    // (starting the time between contacts) on a loop that turns instead.
+    if (collisionDetector.update(imu)) on_contact_made();
     int speed = getForwardSpeed();
     motors.setSpeeds(speed, speed);
   }
@@ -276,7 +220,7 @@ void turn(char direction, bool randomize)
   delay(randomize ? TURN_DURATION + (random(8) - 2) * duration_increment : TURN_DURATION);
   int speed = getForwardSpeed();
   motors.setSpeeds(speed, speed);
-  last_turn_time = millis();
+  collisionDetector.ignoreFor(MIN_DELAY_AFTER_TURN);
 }
 
 void setForwardSpeed(ForwardSpeed speed)
@@ -303,24 +247,17 @@ int getForwardSpeed()
   return speed;
 }
 
-// check for contact, but ignore readings immediately after turning or losing contact
-bool check_for_contact()
-{
-  static long threshold_squared = (long) XY_ACCELERATION_THRESHOLD * (long) XY_ACCELERATION_THRESHOLD;
-  return (acc.ss_xy_avg() >  threshold_squared) && \
-    (loop_start_time - last_turn_time > MIN_DELAY_AFTER_TURN) && \
-    (loop_start_time - contact_made_time > MIN_DELAY_BETWEEN_CONTACTS);
-}
-
 // sound horn and accelerate on contact -- fight or flight
 void on_contact_made()
 {
 #ifdef LOG_SERIAL
-  Serial.print("contact made");
+  Serial.print("contact made, direction ");
+  Serial.print((uint32_t)collisionDetector.getImpactDirection() * 360 / 65536);
+  Serial.print(", magnitude ");
+  Serial.print(collisionDetector.getImpactMagnitude());
   Serial.println();
 #endif
   in_contact = true;
-  contact_made_time = loop_start_time;
   setForwardSpeed(FullSpeed);
   buzzer.playFromProgramSpace(sound_effect);
   ledRed(1);
@@ -337,141 +274,3 @@ void on_contact_lost()
   setForwardSpeed(SearchSpeed);
   ledRed(0);
 }
-
-// class Accelerometer -- member function definitions
-
-void Accelerometer::getLogHeader(void)
-{
-  Serial.print("millis    x      y     len     dir  | len_avg  dir_avg  |  avg_len");
-  Serial.println();
-}
-
-void Accelerometer::readAcceleration(unsigned long timestamp)
-{
-  readAcc();
-  if (a.x == last.x && a.y == last.y) return;
-
-  last.timestamp = timestamp;
-  last.x = a.x;
-  last.y = a.y;
-
-  ra_x.addValue(last.x);
-  ra_y.addValue(last.y);
-
-#ifdef LOG_SERIAL
- Serial.print(last.timestamp);
- Serial.print("  ");
- Serial.print(last.x);
- Serial.print("  ");
- Serial.print(last.y);
- Serial.print("  ");
- Serial.print(len_xy());
- Serial.print("  ");
- Serial.print(dir_xy());
- Serial.print("  |  ");
- Serial.print(sqrt(static_cast<float>(ss_xy_avg())));
- Serial.print("  ");
- Serial.print(dir_xy_avg());
- Serial.println();
-#endif
-}
-
-float Accelerometer::len_xy() const
-{
-  return sqrt(last.x*a.x + last.y*a.y);
-}
-
-float Accelerometer::dir_xy() const
-{
-  return atan2(last.x, last.y) * 180.0 / M_PI;
-}
-
-int Accelerometer::x_avg(void) const
-{
-  return ra_x.getAverage();
-}
-
-int Accelerometer::y_avg(void) const
-{
-  return ra_y.getAverage();
-}
-
-long Accelerometer::ss_xy_avg(void) const
-{
-  long x_avg_long = static_cast<long>(x_avg());
-  long y_avg_long = static_cast<long>(y_avg());
-  return x_avg_long*x_avg_long + y_avg_long*y_avg_long;
-}
-
-float Accelerometer::dir_xy_avg(void) const
-{
-  return atan2(static_cast<float>(x_avg()), static_cast<float>(y_avg())) * 180.0 / M_PI;
-}
-
-
-
-// RunningAverage class
-// based on RunningAverage library for Arduino
-// source:  http://playground.arduino.cc/Main/RunningAverage
-// author:  Rob.Tillart@gmail.com
-// Released to the public domain
-
-template <typename T>
-T RunningAverage<T>::zero = static_cast<T>(0);
-
-template <typename T>
-RunningAverage<T>::RunningAverage(int n)
-{
-  _size = n;
-  _ar = (T*) malloc(_size * sizeof(T));
-  clear();
-}
-
-template <typename T>
-RunningAverage<T>::~RunningAverage()
-{
-  free(_ar);
-}
-
-// resets all counters
-template <typename T>
-void RunningAverage<T>::clear()
-{
-  _cnt = 0;
-  _idx = 0;
-  _sum = zero;
-  for (int i = 0; i< _size; i++) _ar[i] = zero;  // needed to keep addValue simple
-}
-
-// adds a new value to the data-set
-template <typename T>
-void RunningAverage<T>::addValue(T f)
-{
-  _sum -= _ar[_idx];
-  _ar[_idx] = f;
-  _sum += _ar[_idx];
-  _idx++;
-  if (_idx == _size) _idx = 0;  // faster than %
-  if (_cnt < _size) _cnt++;
-}
-
-// returns the average of the data-set added so far
-template <typename T>
-T RunningAverage<T>::getAverage() const
-{
-  if (_cnt == 0) return zero; // NaN ?  math.h
-  return _sum / _cnt;
-}
-
-// fill the average with a value
-// the param number determines how often value is added (weight)
-// number should preferably be between 1 and size
-template <typename T>
-void RunningAverage<T>::fillValue(T value, int number)
-{
-  clear();
-  for (int i = 0; i < number; i++)
-  {
-    addValue(value);
-  }
-}
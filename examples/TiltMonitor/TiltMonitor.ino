@@ -0,0 +1,97 @@
+/* This example uses Zumo32U4TiltMonitor to detect when the Zumo
+is lifted, put on a slope, or spun around by hand.
+
+The display shows how far the robot is tilted and which way is
+uphill, in degrees, and the events that are currently happening:
+L for lifted, S for on a slope, and P for being spun.  The buzzer
+beeps when an event starts, with a different pitch for each
+event, and the event is also printed to the serial monitor.
+
+Keep the robot still for a second after starting it, while the
+yellow LED is on, so that the gyro offset can be measured.  The
+motors are not used, so every fast turn counts as being spun. */
+
+#include <Wire.h>
+#include <Zumo32U4.h>
+
+// Change next line to this if you are using the older Zumo 32U4
+// with a black and green LCD display:
+// Zumo32U4LCD display;
+Zumo32U4OLED display;
+
+Zumo32U4IMU imu;
+Zumo32U4Buzzer buzzer;
+Zumo32U4TiltMonitor tiltMonitor;
+
+void setup()
+{
+  Wire.begin();
+  imu.init();
+  imu.enableDefault();
+  imu.configureForTurnSensing();
+  imu.configureForCollisionDetection();
+
+  // Measure the gyro offset by averaging readings while the
+  // robot is still.
+  ledYellow(1);
+  display.clear();
+  display.print(F("Gyro cal"));
+  int32_t total = 0;
+  for (uint16_t i = 0; i < 1024; i++)
+  {
+    while (!imu.gyroDataReady()) {}
+    imu.readGyro();
+    total += imu.g.z;
+  }
+  tiltMonitor.setGyroOffset(total / 1024);
+  ledYellow(0);
+  display.clear();
+}
+
+// Converts an angle in Zumo32U4Trig units to degrees.
+int16_t toDegrees(uint16_t angle)
+{
+  return (uint32_t)angle * 360 / 65536;
+}
+
+void reportEvents(uint8_t events)
+{
+  if (events & Zumo32U4TiltMonitor::Lifted)
+  {
+    Serial.println(F("lifted"));
+    buzzer.playNote(NOTE_C(6), 100, 15);
+  }
+  if (events & Zumo32U4TiltMonitor::Slope)
+  {
+    Serial.println(F("on slope"));
+    buzzer.playNote(NOTE_G(4), 100, 15);
+  }
+  if (events & Zumo32U4TiltMonitor::Spun)
+  {
+    Serial.println(F("spun"));
+    buzzer.playNote(NOTE_C(5), 100, 15);
+  }
+}
+
+void loop()
+{
+  reportEvents(tiltMonitor.update(imu));
+
+  // Update the display every 100 ms.
+  static uint8_t lastDisplayTime;
+  if ((uint8_t)(millis() - lastDisplayTime) >= 100)
+  {
+    lastDisplayTime = millis();
+
+    display.gotoXY(0, 0);
+    display.print(toDegrees(tiltMonitor.getTiltAngle()));
+    display.print(' ');
+    display.print(toDegrees(tiltMonitor.getTiltDirection()));
+    display.print(F("       "));
+
+    display.gotoXY(0, 1);
+    display.print(tiltMonitor.isLifted() ? 'L' : ' ');
+    display.print(tiltMonitor.isOnSlope() ? 'S' : ' ');
+    display.print(tiltMonitor.isBeingSpun() ? 'P' : ' ');
+  }
+}
@@ -34,6 +34,7 @@
 #include <stdlib.h>
 #include "QTRSensors.h"
 #include <Arduino.h>
+#include <Zumo32U4Timebase.h>
 
 
 
@@ -48,6 +49,18 @@ void QTRSensors::init(unsigned char *pins, unsigned char numSensors,
 
     _lastValue=0; // assume initially that the line is left.
 
+    // The pipeline buffer is sized for the old number of sensors, so free it
+    // and let readPipelined() allocate a new one.
+    if (_pipelineValues)
+        free(_pipelineValues);
+    _pipelineValues=0;
+    _pipelineState=0;
+
+    _adaptive=0;
+
+    _emittersAreOn=0;
+    _calibrating=0;
+
     if (numSensors > QTR_MAX_SENSORS)
         _numSensors = QTR_MAX_SENSORS;
     else
@@ -83,6 +96,12 @@ void QTRSensors::read(unsigned int *sensor_values, unsigned char readMode)
     unsigned int off_values[QTR_MAX_SENSORS];
     unsigned char i;
 
+    if(readMode == QTR_EMITTERS_ON_AND_OFF_PIPELINED)
+    {
+        readPipelined(sensor_values);
+        return;
+    }
+
     if(readMode == QTR_EMITTERS_ON || readMode == QTR_EMITTERS_ON_AND_OFF)
         emittersOn();
     else
@@ -103,12 +122,75 @@ void QTRSensors::read(unsigned int *sensor_values, unsigned char readMode)
 }
 
 
+// Pipeline states for QTR_EMITTERS_ON_AND_OFF_PIPELINED.
+#define QTR_PIPELINE_EMPTY    0
+#define QTR_PIPELINE_NEXT_ON  1
+#define QTR_PIPELINE_NEXT_OFF 2
+
+// Takes just one reading, alternating between the emitters being on and
+// off, and combines it with the latest reading in the other state.
+void QTRSensors::readPipelined(unsigned int *sensor_values)
+{
+    unsigned char i;
+
+    if(_pipelineValues == 0)
+    {
+        _pipelineValues = (unsigned int*)malloc(sizeof(unsigned int)*_numSensors*2);
+
+        // If the malloc failed, take both readings every time.
+        if(_pipelineValues == 0)
+        {
+            read(sensor_values, QTR_EMITTERS_ON_AND_OFF);
+            return;
+        }
+        _pipelineState = QTR_PIPELINE_EMPTY;
+    }
+
+    unsigned int *on_values = _pipelineValues;
+    unsigned int *off_values = _pipelineValues + _numSensors;
+
+    if(_pipelineState != QTR_PIPELINE_NEXT_OFF)
+    {
+        emittersOn();
+        _pipelineOnTime = micros();
+        readPrivate(on_values);
+    }
+    emittersOff();
+    if(_pipelineState != QTR_PIPELINE_NEXT_ON)
+    {
+        _pipelineOffTime = micros();
+        readPrivate(off_values);
+    }
+    _pipelineState = (_pipelineState == QTR_PIPELINE_NEXT_ON) ?
+        QTR_PIPELINE_NEXT_OFF : QTR_PIPELINE_NEXT_ON;
+
+    for(i=0;i<_numSensors;i++)
+    {
+        sensor_values[i] = on_values[i] + _maxValue - off_values[i];
+    }
+}
+
+unsigned int QTRSensors::getPipelineStaleness()
+{
+    if(_pipelineState == QTR_PIPELINE_EMPTY)
+        return 0;
+
+    unsigned long age;
+    if(_pipelineState == QTR_PIPELINE_NEXT_OFF)
+        age = _pipelineOnTime - _pipelineOffTime;  // just read on
+    else
+        age = _pipelineOffTime - _pipelineOnTime;  // just read off
+    return age > 0xFFFF ? 0xFFFF : age;
+}
+
+
 // Turn the IR LEDs off and on.  This is mainly for use by the
 // read method, and calling these functions before or
 // after the reading the sensors will have no effect on the
 // readings, but you may wish to use these for testing purposes.
 void QTRSensors::emittersOff()
 {
+    _emittersAreOn = 0;
     if (_emitterPin == QTR_NO_EMITTER_PIN)
         return;
     pinMode(_emitterPin, OUTPUT);
@@ -118,6 +200,7 @@ void QTRSensors::emittersOff()
 
 void QTRSensors::emittersOn()
 {
+    _emittersAreOn = 1;
     if (_emitterPin == QTR_NO_EMITTER_PIN)
         return;
     pinMode(_emitterPin, OUTPUT);
@@ -148,6 +231,10 @@ void QTRSensors::resetCalibration()
 // and used for the readCalibrated() method.
 void QTRSensors::calibrate(unsigned char readMode)
 {
+    // The pipelined mode uses the same calibration as QTR_EMITTERS_ON_AND_OFF.
+    if(readMode == QTR_EMITTERS_ON_AND_OFF_PIPELINED)
+        readMode = QTR_EMITTERS_ON_AND_OFF;
+
     if(readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_ON)
     {
         calibrateOnOrOff(&calibratedMinimumOn,
@@ -173,14 +260,51 @@ void QTRSensors::calibrateOnOrOff(unsigned int **calibratedMinimum,
     unsigned int max_sensor_values[16];
     unsigned int min_sensor_values[16];
 
-    // Allocate the arrays if necessary.
+    // If the malloc failed, don't continue.
+    if(!allocateCalibration(calibratedMinimum, calibratedMaximum))
+        return;
+
+    _calibrating = 1;
+
+    int j;
+    for(j=0;j<10;j++)
+    {
+        read(sensor_values,readMode);
+        for(i=0;i<_numSensors;i++)
+        {
+            // set the max we found THIS time
+            if(j == 0 || max_sensor_values[i] < sensor_values[i])
+                max_sensor_values[i] = sensor_values[i];
+
+            // set the min we found THIS time
+            if(j == 0 || min_sensor_values[i] > sensor_values[i])
+                min_sensor_values[i] = sensor_values[i];
+        }
+    }
+
+    _calibrating = 0;
+
+    // record the min and max calibration values
+    for(i=0;i<_numSensors;i++)
+    {
+        if(min_sensor_values[i] > (*calibratedMaximum)[i])
+            (*calibratedMaximum)[i] = min_sensor_values[i];
+        if(max_sensor_values[i] < (*calibratedMinimum)[i])
+            (*calibratedMinimum)[i] = max_sensor_values[i];
+    }
+}
+
+bool QTRSensors::allocateCalibration(unsigned int **calibratedMinimum,
+                                     unsigned int **calibratedMaximum)
+{
+    int i;
+
     if(*calibratedMaximum == 0)
     {
         *calibratedMaximum = (unsigned int*)malloc(sizeof(unsigned int)*_numSensors);
 
-        // If the malloc failed, don't continue.
         if(*calibratedMaximum == 0)
-            return;
+            return false;
 
         // Initialize the max and min calibrated values to values that
         // will cause the first reading to update them.
@@ -192,37 +316,86 @@ void QTRSensors::calibrateOnOrOff(unsigned int **calibratedMinimum,
     {
         *calibratedMinimum = (unsigned int*)malloc(sizeof(unsigned int)*_numSensors);
 
-        // If the malloc failed, don't continue.
         if(*calibratedMinimum == 0)
-            return;
+            return false;
 
         for(i=0;i<_numSensors;i++)
             (*calibratedMinimum)[i] = _maxValue;
     }
+    return true;
+}
 
-    int j;
-    for(j=0;j<10;j++)
+
+// Enables or disables adaptive calibration, which updates the
+// calibrated minimum and maximum values from the readings taken by
+// readCalibrated().
+void QTRSensors::setAdaptiveCalibration(unsigned char enabled,
+    unsigned int maxStep, unsigned char decayInterval)
+{
+    _adaptive = enabled;
+    _adaptiveMaxStep = maxStep;
+    _adaptiveDecayInterval = decayInterval;
+    _adaptiveDecayCount = 0;
+}
+
+void QTRSensors::adaptCalibration(const unsigned int *sensor_values,
+                                  unsigned int *calibratedMinimum,
+                                  unsigned int *calibratedMaximum,
+                                  bool fresh)
+{
+    unsigned char i;
+
+    // Freshly allocated arrays have each minimum above its maximum, so that
+    // calibrate() can start from them.  Stepping toward the readings from
+    // there would leave the range inverted for several readings, so start
+    // both limits at the first reading instead.
+    if(fresh)
     {
-        read(sensor_values,readMode);
         for(i=0;i<_numSensors;i++)
-        {
-            // set the max we found THIS time
-            if(j == 0 || max_sensor_values[i] < sensor_values[i])
-                max_sensor_values[i] = sensor_values[i];
+            calibratedMinimum[i] = calibratedMaximum[i] = sensor_values[i];
+        return;
+    }
 
-            // set the min we found THIS time
-            if(j == 0 || min_sensor_values[i] > sensor_values[i])
-                min_sensor_values[i] = sensor_values[i];
-        }
+    bool decay = false;
+    if(++_adaptiveDecayCount >= _adaptiveDecayInterval)
+    {
+        _adaptiveDecayCount = 0;
+        decay = true;
     }
 
-    // record the min and max calibration values
+    unsigned int minRange = _maxValue / 4;
+
     for(i=0;i<_numSensors;i++)
     {
-        if(min_sensor_values[i] > (*calibratedMaximum)[i])
-            (*calibratedMaximum)[i] = min_sensor_values[i];
-        if(max_sensor_values[i] < (*calibratedMinimum)[i])
-            (*calibratedMinimum)[i] = max_sensor_values[i];
+        unsigned int value = sensor_values[i];
+        unsigned int calmin = calibratedMinimum[i];
+        unsigned int calmax = calibratedMaximum[i];
+
+        // Move the limits out toward readings outside of the range, but
+        // by no more than the maximum step so that single outliers are
+        // mostly ignored.
+        if(value > calmax)
+        {
+            unsigned int diff = value - calmax;
+            calmax += diff < _adaptiveMaxStep ? diff : _adaptiveMaxStep;
+        }
+        else if(decay && value < calmax && calmax - calmin > minRange)
+        {
+            calmax--;
+        }
+
+        if(value < calmin)
+        {
+            unsigned int diff = calmin - value;
+            calmin -= diff < _adaptiveMaxStep ? diff : _adaptiveMaxStep;
+        }
+        else if(decay && value > calmin && calmax - calmin > minRange)
+        {
+            calmin++;
+        }
+
+        calibratedMinimum[i] = calmin;
+        calibratedMaximum[i] = calmax;
     }
 }
 
@@ -236,17 +409,43 @@ void QTRSensors::readCalibrated(unsigned int *sensor_values, unsigned char readM
 {
     int i;
 
+    // in adaptive mode, the calibration starts from the readings
+    bool fresh = false;
+    if(_adaptive && readMode == QTR_EMITTERS_ON)
+    {
+        fresh = !calibratedMinimumOn || !calibratedMaximumOn;
+        allocateCalibration(&calibratedMinimumOn, &calibratedMaximumOn);
+    }
+    if(_adaptive && readMode == QTR_EMITTERS_OFF)
+    {
+        fresh = !calibratedMinimumOff || !calibratedMaximumOff;
+        allocateCalibration(&calibratedMinimumOff, &calibratedMaximumOff);
+    }
+
+    bool on_and_off = readMode == QTR_EMITTERS_ON_AND_OFF ||
+                      readMode == QTR_EMITTERS_ON_AND_OFF_PIPELINED;
+
     // if not calibrated, do nothing
-    if(readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_OFF)
+    if(on_and_off || readMode == QTR_EMITTERS_OFF)
         if(!calibratedMinimumOff || !calibratedMaximumOff)
             return;
-    if(readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_ON)
+    if(on_and_off || readMode == QTR_EMITTERS_ON)
         if(!calibratedMinimumOn || !calibratedMaximumOn)
             return;
 
     // read the needed values
     read(sensor_values,readMode);
 
+    if(_adaptive)
+    {
+        if(readMode == QTR_EMITTERS_ON)
+            adaptCalibration(sensor_values, calibratedMinimumOn, calibratedMaximumOn,
+                             fresh);
+        else if(readMode == QTR_EMITTERS_OFF)
+            adaptCalibration(sensor_values, calibratedMinimumOff, calibratedMaximumOff,
+                             fresh);
+    }
+
     for(i=0;i<_numSensors;i++)
     {
         unsigned int calmin,calmax;
@@ -263,7 +462,7 @@ void QTRSensors::readCalibrated(unsigned int *sensor_values, unsigned char readM
             calmax = calibratedMaximumOff[i];
             calmin = calibratedMinimumOff[i];
         }
-        else // QTR_EMITTERS_ON_AND_OFF
+        else // QTR_EMITTERS_ON_AND_OFF or QTR_EMITTERS_ON_AND_OFF_PIPELINED
         {
 
             if(calibratedMinimumOff[i] < calibratedMinimumOn[i]) // no meaningful signal
@@ -369,6 +568,10 @@ QTRSensorsRC::QTRSensorsRC()
     calibratedMinimumOff = 0;
     calibratedMaximumOff = 0;
     _pins = 0;
+    _useTimebase = 0;
+    _useCalibratedTimeout = 0;
+    _samples = 0;
+    _numSamples = 1;
 }
 
 QTRSensorsRC::QTRSensorsRC(unsigned char* pins,
@@ -379,6 +582,10 @@ QTRSensorsRC::QTRSensorsRC(unsigned char* pins,
     calibratedMinimumOff = 0;
     calibratedMaximumOff = 0;
     _pins = 0;
+    _useTimebase = 0;
+    _useCalibratedTimeout = 0;
+    _samples = 0;
+    _numSamples = 1;
 
     init(pins, numSensors, timeout, emitterPin);
 }
@@ -413,6 +620,54 @@ void QTRSensorsRC::init(unsigned char* pins,
 }
 
 
+// Makes read() time the sensor pulses with Zumo32U4Timebase instead of
+// micros().
+void QTRSensorsRC::useTimebase(bool use)
+{
+    if (use)
+        Zumo32U4Timebase::init();
+    _useTimebase = use;
+}
+
+
+// Makes readings with the emitters on stop at the largest calibrated
+// maximum plus a margin.
+void QTRSensorsRC::useCalibratedTimeout(bool use, unsigned int margin)
+{
+    _useCalibratedTimeout = use;
+    _calibratedTimeoutMargin = margin;
+}
+
+
+// Makes each reading combine several timings of each sensor.
+bool QTRSensorsRC::setOversampling(unsigned char samples,
+    unsigned char filter, bool pipelined)
+{
+    if (_samples)
+    {
+        free(_samples);
+        _samples = 0;
+    }
+    _numSamples = 1;
+
+    if (samples > QTR_MAX_SAMPLES)
+        samples = QTR_MAX_SAMPLES;
+    if (samples <= 1)
+        return true;
+
+    _samples = (unsigned int*)malloc(sizeof(unsigned int)*_numSensors*samples);
+    if (_samples == 0)
+        return false;
+
+    _numSamples = samples;
+    _sampleFilter = filter;
+    _samplePipelined = pipelined;
+    _sampleIndex = 0;
+    _sampleCount = 0;
+    return true;
+}
+
+
 // Reads the sensor values into an array. There *MUST* be space
 // for as many values as there were sensors specified in the constructor.
 // Example usage:
@@ -422,15 +677,111 @@ void QTRSensorsRC::init(unsigned char* pins,
 // The values returned are in microseconds and range from 0 to
 // timeout (as specified in the constructor).
 void QTRSensorsRC::readPrivate(unsigned int *sensor_values)
+{
+    unsigned char j;
+
+    if (_numSamples <= 1 || _pins == 0)
+    {
+        readPass(sensor_values);
+        return;
+    }
+
+    if (!_samplePipelined)
+    {
+        for (j = 0; j < _numSamples; j++)
+            readPass(_samples + j * _numSensors);
+        filterSamples(sensor_values, _numSamples);
+        return;
+    }
+
+    // Readings with the emitters off and calibration readings would mix
+    // different kinds of values into the stored samples.
+    if (!_emittersAreOn || _calibrating)
+    {
+        readPass(sensor_values);
+        return;
+    }
+
+    readPass(_samples + _sampleIndex * _numSensors);
+    if (++_sampleIndex == _numSamples)
+        _sampleIndex = 0;
+    if (_sampleCount < _numSamples)
+        _sampleCount++;
+    filterSamples(sensor_values, _sampleCount);
+}
+
+
+void QTRSensorsRC::filterSamples(unsigned int *sensor_values,
+    unsigned char count)
+{
+    unsigned char i, j, k;
+    unsigned int sorted[QTR_MAX_SAMPLES];
+
+    for (i = 0; i < _numSensors; i++)
+    {
+        // Insertion sort is fast for this few samples.
+        for (j = 0; j < count; j++)
+        {
+            unsigned int value = _samples[j * _numSensors + i];
+            for (k = j; k > 0 && sorted[k - 1] > value; k--)
+                sorted[k] = sorted[k - 1];
+            sorted[k] = value;
+        }
+
+        if (_sampleFilter == QTR_FILTER_TRIMMED_MEAN && count >= 3)
+        {
+            unsigned long sum = 0;
+            for (j = 1; j < count - 1; j++)
+                sum += sorted[j];
+            sensor_values[i] = sum / (count - 2);
+        }
+        else
+        {
+            sensor_values[i] = sorted[count / 2];
+        }
+    }
+}
+
+
+// Times the sensor pulses once.  This is what readPrivate() does when
+// oversampling is disabled.
+void QTRSensorsRC::readPass(unsigned int *sensor_values)
 {
     unsigned char i;
 
     if (_pins == 0)
         return;
 
+    // Find out how long to wait for the sensors.  Readings past the
+    // calibrated maximum would be calibrated to 1000 anyway.
+    unsigned int timeout = _maxValue;
+    if (_useCalibratedTimeout && _emittersAreOn && !_calibrating &&
+        calibratedMaximumOn)
+    {
+        unsigned int calmax = 0;
+        for (i = 0; i < _numSensors; i++)
+        {
+            if (calibratedMaximumOn[i] > calmax)
+                calmax = calibratedMaximumOn[i];
+        }
+        if (_calibratedTimeoutMargin < _maxValue &&
+            calmax < _maxValue - _calibratedTimeoutMargin)
+            timeout = calmax + _calibratedTimeoutMargin;
+    }
+
+    // Only stop as soon as every sensor has discharged if the calibrated
+    // timeout is enabled.  Otherwise a reading always takes the full timeout,
+    // as it always has, because some code (like the MazeSolver example)
+    // counts readings to measure time.
+    bool stopEarly = _useCalibratedTimeout;
+    unsigned char remaining = _numSensors;
+
+    // Sensors that do not discharge in time read as the shortened timeout,
+    // not _maxValue, so that adaptive calibration does not move their
+    // calibrated maximum past what was actually measured.
     for(i = 0; i < _numSensors; i++)
     {
-        sensor_values[i] = _maxValue;
+        sensor_values[i] = timeout;
         digitalWrite(_pins[i], HIGH);   // make sensor line an output
         pinMode(_pins[i], OUTPUT);      // drive sensor line high
     }
@@ -443,14 +794,40 @@ void QTRSensorsRC::readPrivate(unsigned int *sensor_values)
         digitalWrite(_pins[i], LOW);        // important: disable internal pull-up!
     }
 
+    // The time base counts in 16-bit ticks of 0.5 us, so it can only be used
+    // if the timeout fits in 32767 us.
+    if (_useTimebase && timeout < 0x8000)
+    {
+        unsigned int maxTicks = timeout * Zumo32U4Timebase::ticksPerUs;
+        uint16_t startTicks = Zumo32U4Timebase::ticks();
+        uint16_t ticks;
+        while ((remaining || !stopEarly) &&
+            (ticks = Zumo32U4Timebase::ticks() - startTicks) < maxTicks)
+        {
+            unsigned int time = Zumo32U4Timebase::ticksToUs(ticks);
+            for (i = 0; i < _numSensors; i++)
+            {
+                if (digitalRead(_pins[i]) == LOW && time < sensor_values[i])
+                {
+                    sensor_values[i] = time;
+                    remaining--;
+                }
+            }
+        }
+        return;
+    }
+
     unsigned long startTime = micros();
-    while (micros() - startTime < _maxValue)
+    while ((remaining || !stopEarly) && micros() - startTime < timeout)
     {
         unsigned int time = micros() - startTime;
         for (i = 0; i < _numSensors; i++)
         {
             if (digitalRead(_pins[i]) == LOW && time < sensor_values[i])
+            {
                 sensor_values[i] = time;
+                remaining--;
+            }
         }
     }
 }
@@ -465,6 +842,9 @@ QTRSensorsAnalog::QTRSensorsAnalog()
     calibratedMinimumOff = 0;
     calibratedMaximumOff = 0;
     _pins = 0;
+    _channels = 0;
+    _latest = 0;
+    _background = 0;
 }
 
 QTRSensorsAnalog::QTRSensorsAnalog(unsigned char* pins,
@@ -476,6 +856,9 @@ QTRSensorsAnalog::QTRSensorsAnalog(unsigned char* pins,
     calibratedMinimumOff = 0;
     calibratedMaximumOff = 0;
     _pins = 0;
+    _channels = 0;
+    _latest = 0;
+    _background = 0;
 
     init(pins, numSensors, numSamplesPerSensor, emitterPin);
 }
@@ -508,6 +891,11 @@ void QTRSensorsAnalog::init(unsigned char* pins,
     unsigned char numSensors, unsigned char numSamplesPerSensor,
     unsigned char emitterPin)
 {
+    // The background reading buffers are sized for the old number of
+    // sensors, so free them and let startBackgroundRead() allocate new ones.
+    stopBackgroundRead();
+    freeBackgroundBuffers();
+
     QTRSensors::init(pins, numSensors, emitterPin);
 
     _numSamplesPerSensor = numSamplesPerSensor;
@@ -530,6 +918,12 @@ void QTRSensorsAnalog::readPrivate(unsigned int *sensor_values)
     if (_pins == 0)
         return;
 
+    if (_background)
+    {
+        readLatest(sensor_values);
+        return;
+    }
+
     // reset the values
     for(i = 0; i < _numSensors; i++)
         sensor_values[i] = 0;
@@ -548,6 +942,63 @@ void QTRSensorsAnalog::readPrivate(unsigned int *sensor_values)
             _numSamplesPerSensor;
 }
 
+
+// Copies the latest results of the background conversions.  This is here
+// rather than in QTRSensorsBackground.cpp so that readPrivate() does not
+// cause the ADC interrupt to be linked into programs that do not use it.
+void QTRSensorsAnalog::readLatest(unsigned int *sensor_values)
+{
+    unsigned char i;
+
+    if (_latest == 0)
+        return;
+
+    // The interrupt writes these 16-bit values, so read them with interrupts
+    // disabled.
+    unsigned char sreg = SREG;
+    cli();
+    for (i = 0; i < _numSensors; i++)
+        sensor_values[i] = _latest[i];
+    SREG = sreg;
+}
+
+// Stops the background reading.  This is here rather than in
+// QTRSensorsBackground.cpp so that the destructor and init() do not cause
+// the ADC interrupt to be linked into programs that do not use it.
+void QTRSensorsAnalog::stopBackgroundRead()
+{
+    if (!_background)
+        return;
+
+    // Disable the interrupt so that no more conversions are started, wait
+    // for the current one to finish, and restore the prescaler that
+    // analogRead() expects.
+    ADCSRA &= ~(1 << ADIE);
+    while (ADCSRA & (1 << ADSC)) {}
+    ADCSRA = (1 << ADEN) | (1 << ADIF) | 7;
+
+    _background = 0;
+}
+
+void QTRSensorsAnalog::freeBackgroundBuffers()
+{
+    if (_channels)
+        free(_channels);
+    if (_latest)
+        free((void*)_latest);
+    _channels = 0;
+    _latest = 0;
+}
+
+unsigned int QTRSensorsAnalog::getBackgroundCycleCount()
+{
+    unsigned char sreg = SREG;
+    cli();
+    unsigned int count = _cycleCount;
+    SREG = sreg;
+    return count;
+}
+
 // the destructor frees up allocated memory
 QTRSensors::~QTRSensors()
 {
@@ -561,4 +1012,18 @@ QTRSensors::~QTRSensors()
         free(calibratedMinimumOn);
     if(calibratedMinimumOff)
         free(calibratedMinimumOff);
+    if(_pipelineValues)
+        free(_pipelineValues);
+}
+
+QTRSensorsRC::~QTRSensorsRC()
+{
+    if (_samples)
+        free(_samples);
+}
+
+QTRSensorsAnalog::~QTRSensorsAnalog()
+{
+    stopBackgroundRead();
+    freeBackgroundBuffers();
 }
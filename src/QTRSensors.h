@@ -61,10 +61,40 @@
 /// emitter control will only work if you specify a valid emitter pin in the
 /// constructor.
 #define QTR_EMITTERS_ON_AND_OFF 2
+
+/// \brief Specifies that each reading should be made with the emitters either
+/// on or off, alternating between calls, and combined with the most recent
+/// reading in the other state.
+///
+/// The values returned are given by *on + max – off*, like
+/// `QTR_EMITTERS_ON_AND_OFF`, but only one of the two readings is taken
+/// on each call, so a call takes about half as long.  The price is that one
+/// of the readings was taken during the previous call, so if the robot is
+/// moving, the two readings are of slightly different spots.  See
+/// QTRSensors::getPipelineStaleness().  The first call with this mode takes
+/// both readings.
+#define QTR_EMITTERS_ON_AND_OFF_PIPELINED 3
 /// @}
 
 #define QTR_NO_EMITTER_PIN  255
 
+/// \defgroup oversampling_filters Oversampling filters
+///
+/// Ways to combine several readings of each sensor (see
+/// QTRSensorsRC::setOversampling()).
+///
+/// @{
+
+/// \brief Returns the median of the samples.
+#define QTR_FILTER_MEDIAN 0
+
+/// \brief Returns the mean of the samples after discarding the lowest and
+/// the highest one.
+#define QTR_FILTER_TRIMMED_MEAN 1
+/// @}
+
+#define QTR_MAX_SAMPLES 9
+
 #define QTR_MAX_SENSORS 16
 
 // This class cannot be instantiated directly (it has no constructor).
@@ -126,6 +156,52 @@ class QTRSensors
     /// \brief Resets all calibration that has been done.
     void resetCalibration();
 
+    /// \brief Enables or disables adaptive calibration.
+    ///
+    /// \param enabled True to enable adaptive calibration.
+    ///
+    /// \param maxStep The most that one reading can move a calibrated minimum
+    /// or maximum value, in the units of the raw readings.
+    ///
+    /// \param decayInterval The number of readings between steps of the
+    /// decay described below.
+    ///
+    /// When adaptive calibration is enabled, every call to readCalibrated()
+    /// with `QTR_EMITTERS_ON` or `QTR_EMITTERS_OFF` also uses the raw readings
+    /// to update the calibrated minimum and maximum values for that mode, so
+    /// the calibration follows slow changes in ambient light while the robot
+    /// is running.  If calibrate() was never called, the calibration arrays
+    /// are allocated by readCalibrated(), and both limits of each sensor
+    /// start at its first reading, so the calibration sweep can be skipped.
+    /// The calibrated values are 0 until the limits have spread apart, and
+    /// the results are poor until every sensor has seen both the line and
+    /// the background.
+    ///
+    /// A reading outside the calibrated range moves the limit toward it by at
+    /// most `maxStep`, so a real change is followed within a few readings.
+    /// This limit on each step is the only protection against outliers: a
+    /// single noisy reading is not rejected, but it can move a limit by no
+    /// more than `maxStep`.  Once every `decayInterval` readings, each limit
+    /// also moves one unit toward the current reading, so that old extremes
+    /// are slowly forgotten.  The decay stops when the calibrated range is a
+    /// quarter of the maximum raw value, so a sensor that does not see the
+    /// line for a long time keeps a useful range.
+    ///
+    /// The cost is a few comparisons per sensor per reading.
+    void setAdaptiveCalibration(unsigned char enabled,
+        unsigned int maxStep = 100, unsigned char decayInterval = 16);
+
+    /// \brief Returns the time between the two readings that were combined by
+    /// the last read with `QTR_EMITTERS_ON_AND_OFF_PIPELINED`, in
+    /// microseconds.
+    ///
+    /// This is how much older the reading from the previous call was than the
+    /// one just taken, which is normally the time between calls.  The result
+    /// is limited to 65535.  You can use it to ignore or distrust readings
+    /// whose other half is too old, for example after the robot spent some
+    /// time doing something else.
+    unsigned int getPipelineStaleness();
+
     /// \brief Reads the sensors and provides calibrated values between 0 and
     /// 1000.
     ///
@@ -203,7 +279,9 @@ class QTRSensors
 
     QTRSensors()
     {
-
+        // This is private, so the derived classes' constructors cannot
+        // clear it.  ~QTRSensors() frees it even if init() was never called.
+        _pipelineValues = 0;
     };
 
     void init(unsigned char *pins, unsigned char numSensors, unsigned char emitterPin);
@@ -213,11 +291,41 @@ class QTRSensors
     unsigned char _emitterPin;
     unsigned int _maxValue; // the maximum value returned by this function
     int _lastValue;
+    unsigned char _emittersAreOn; // set by emittersOn() and emittersOff()
+    unsigned char _calibrating; // set while calibrate() is reading
 
   private:
 
     virtual void readPrivate(unsigned int *sensor_values) = 0;
 
+    // Allocates the calibration arrays if necessary.  Returns false if the
+    // allocation failed.
+    bool allocateCalibration(unsigned int **calibratedMinimum,
+                             unsigned int **calibratedMaximum);
+
+    // Moves the calibrated minimum and maximum values toward the readings
+    // (see setAdaptiveCalibration()), or sets both to the readings if the
+    // arrays were just allocated.
+    void adaptCalibration(const unsigned int *sensor_values,
+                          unsigned int *calibratedMinimum,
+                          unsigned int *calibratedMaximum,
+                          bool fresh);
+
+    // Takes one reading for QTR_EMITTERS_ON_AND_OFF_PIPELINED.
+    void readPipelined(unsigned int *sensor_values);
+
+    // The latest readings with the emitters on, followed by the latest
+    // readings with the emitters off, for QTR_EMITTERS_ON_AND_OFF_PIPELINED.
+    unsigned int *_pipelineValues;
+    unsigned char _pipelineState;
+    unsigned long _pipelineOnTime;
+    unsigned long _pipelineOffTime;
+
+    unsigned char _adaptive;
+    unsigned char _adaptiveDecayInterval;
+    unsigned char _adaptiveDecayCount;
+    unsigned int _adaptiveMaxStep;
+
     // Handles the actual calibration. calibratedMinimum and
     // calibratedMaximum are pointers to the requested calibration
     // arrays, which will be allocated if necessary.
@@ -237,6 +345,8 @@ class QTRSensorsRC : public QTRSensors
     // the methods in this class
     QTRSensorsRC();
 
+    ~QTRSensorsRC();
+
     // this constructor just calls init()
     QTRSensorsRC(unsigned char* pins, unsigned char numSensors,
           unsigned int timeout = 4000, unsigned char emitterPin = 255);
@@ -264,6 +374,54 @@ class QTRSensorsRC : public QTRSensors
     void init(unsigned char* pins, unsigned char numSensors,
           unsigned int timeout = 2000, unsigned char emitterPin = QTR_NO_EMITTER_PIN);
 
+    // Makes read() time the sensor pulses with Zumo32U4Timebase (Timer 3)
+    // instead of micros().  The time base has a resolution of 0.5 us and
+    // can be read in a few cycles, while micros() has a resolution of 4 us
+    // and takes several microseconds to run, so this makes the readings
+    // finer and lets the polling loop check the pins more often.  Calling
+    // this function with an argument of true starts the time base if it is
+    // not running already.  The readings are still reported in
+    // microseconds.
+    void useTimebase(bool use = true);
+
+    // Makes readings with the emitters on stop timing the sensor pulses at
+    // the largest of the calibratedMaximumOn values plus 'margin', instead
+    // of waiting up to the full timeout.  Sensors that have not discharged
+    // by then read as that shortened timeout, which readCalibrated() reports
+    // as 1000 just like any other reading above the calibrated maximum, so
+    // calibrated readings are unaffected but dark surfaces take less time to
+    // read.  With adaptive calibration, such a reading can only raise the
+    // calibrated maximum up to the shortened timeout, which is never more
+    // than the sensor would really have read.  While this is enabled, every
+    // reading (with the emitters on or off) also stops as soon as all of the
+    // sensors have discharged, so a reading of a light surface takes only a
+    // few hundred microseconds; do not enable it if your code counts
+    // readings to measure time.  The shortened timeout has no effect until
+    // calibrate() has been called with the emitters on, and it is ignored
+    // while calibrating.
+    void useCalibratedTimeout(bool use = true, unsigned int margin = 100);
+
+    // Makes each reading combine 'samples' timings of each sensor, using
+    // 'filter' (QTR_FILTER_MEDIAN or QTR_FILTER_TRIMMED_MEAN), to reduce
+    // noise.  'samples' can be from 1 (the default, no oversampling) to
+    // QTR_MAX_SAMPLES; 3 or 5 is usually enough to remove occasional
+    // outliers.
+    //
+    // If 'pipelined' is false, each reading times the sensors 'samples'
+    // times in a row, so it takes 'samples' times as long.  If 'pipelined'
+    // is true, each reading times the sensors just once and combines that
+    // with the timings from the previous 'samples' - 1 readings, so
+    // readings take no longer but respond to changes more slowly; this is
+    // meant for loops that read the sensors at a steady rate and do other
+    // work in between.  Pipelining only applies to readings with the
+    // emitters on; other readings are taken once and are not stored.
+    //
+    // This function must be called after init().  It allocates memory for
+    // the samples and returns false if the allocation failed, in which case
+    // oversampling is disabled.
+    bool setOversampling(unsigned char samples,
+        unsigned char filter = QTR_FILTER_MEDIAN, bool pipelined = false);
+
 
 
   private:
@@ -275,6 +433,25 @@ class QTRSensorsRC : public QTRSensors
     // sensors.read(sensor_values);
     // The values returned are a measure of the reflectance in microseconds.
     void readPrivate(unsigned int *sensor_values);
+
+    // Times the sensor pulses once.
+    void readPass(unsigned int *sensor_values);
+
+    // Combines the samples of each sensor in _samples using the
+    // oversampling filter.
+    void filterSamples(unsigned int *sensor_values, unsigned char count);
+
+    unsigned char _useTimebase;
+    unsigned char _useCalibratedTimeout;
+    unsigned int _calibratedTimeoutMargin;
+
+    // _numSamples groups of _numSensors timings, for oversampling.
+    unsigned int *_samples;
+    unsigned char _numSamples;
+    unsigned char _sampleFilter;
+    unsigned char _samplePipelined;
+    unsigned char _sampleIndex;  // the next group to fill when pipelined
+    unsigned char _sampleCount;  // the number of groups filled when pipelined
 };
 
 
@@ -288,6 +465,8 @@ class QTRSensorsAnalog : public QTRSensors
     // the methods in this class
     QTRSensorsAnalog();
 
+    ~QTRSensorsAnalog();
+
     // this constructor just calls init()
     QTRSensorsAnalog(unsigned char* pins,
         unsigned char numSensors, unsigned char numSamplesPerSensor = 4,
@@ -319,6 +498,44 @@ class QTRSensorsAnalog : public QTRSensors
     void init(unsigned char* analogPins, unsigned char numSensors,
         unsigned char numSamplesPerSensor = 4, unsigned char emitterPin = QTR_NO_EMITTER_PIN);
 
+    // Starts converting the sensor voltages in the background.  The ADC
+    // interrupt stores each result and starts the conversion for the next
+    // sensor, cycling through all of the sensors continuously, so
+    // readLatest() can return the latest values immediately.  While this is
+    // running, read(), readCalibrated(), and readLine() also use the latest
+    // values instead of waiting for conversions, so they should be used with
+    // QTR_EMITTERS_ON or with sensors that have no emitter pin; the emitter
+    // pin is still switched, but the values are not synchronized with it.
+    //
+    // 'prescaler' selects the ADC clock, which is the CPU clock divided by
+    // 2 to the power of 'prescaler' (from 2 to 7).  The default of 7 is
+    // what analogRead() uses: 125 kHz, or 104 us per conversion.  A value
+    // of 6 halves the conversion time with little loss of accuracy, and 5
+    // halves it again but is only accurate to about 8 bits.
+    //
+    // Only one object can read in the background at a time, and it takes
+    // over the ADC: you must not call analogRead() (which is also used by
+    // readBatteryMillivolts()) until you call stopBackgroundRead().  The
+    // background reading is implemented in a separate file that defines
+    // ISR(ADC_vect), so a program that uses it cannot define its own ADC
+    // interrupt.
+    //
+    // Returns false if memory for the results could not be allocated.
+    bool startBackgroundRead(unsigned char prescaler = 7);
+
+    // Stops converting in the background after the current conversion.
+    void stopBackgroundRead();
+
+    // Copies the latest background conversion result for each sensor into
+    // 'sensor_values' without waiting.  Before the first full cycle through
+    // the sensors, some values are 0.
+    void readLatest(unsigned int *sensor_values);
+
+    // Returns the number of times the background reading has gone through
+    // all of the sensors.  This can be compared to an earlier value to see
+    // whether readLatest() will return new values.
+    unsigned int getBackgroundCycleCount();
+
 
 
   private:
@@ -333,7 +550,17 @@ class QTRSensorsAnalog : public QTRSensors
     // reflectance (e.g. a black surface or a void).
     void readPrivate(unsigned int *sensor_values);
 
+    // Frees the buffers allocated by startBackgroundRead().
+    void freeBackgroundBuffers();
+
     unsigned char _numSamplesPerSensor;
+
+    // The ADC channel of each sensor and the latest result for each
+    // sensor, for background reading.
+    unsigned char *_channels;
+    volatile unsigned int *_latest;
+    volatile unsigned int _cycleCount;
+    unsigned char _background;
 };
 
 
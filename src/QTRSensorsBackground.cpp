@@ -0,0 +1,104 @@
+/*
+  QTRSensorsBackground.cpp - Background ADC reading for QTRSensorsAnalog.
+
+  This is a separate file so that the ADC interrupt is only linked into
+  programs that call QTRSensorsAnalog::startBackgroundRead().
+*/
+
+#include <stdlib.h>
+#include "QTRSensors.h"
+#include <Arduino.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+// The state used by the ADC interrupt.  Only one object can read in the
+// background at a time.  adcOwner is only valid while the interrupt is
+// enabled, because stopBackgroundRead() disables it and every object stops
+// its own background read before it is destroyed.
+static QTRSensorsAnalog *adcOwner = 0;
+static unsigned char *adcChannels;
+static volatile unsigned int *adcResults;
+static volatile unsigned int *adcCycleCount;
+static unsigned char adcCount;
+static unsigned char adcIndex;
+
+// Selects an ADC channel, using the same reference as analogRead() (AVCC).
+static inline void adcSelect(unsigned char channel)
+{
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 1) << MUX5);
+    ADMUX = (1 << REFS0) | (channel & 7);
+}
+
+// Stores the result for the current sensor, then selects the next sensor
+// and starts converting it.
+ISR(ADC_vect)
+{
+    adcResults[adcIndex] = ADC;
+
+    if (++adcIndex == adcCount)
+    {
+        adcIndex = 0;
+        (*adcCycleCount)++;
+    }
+
+    adcSelect(adcChannels[adcIndex]);
+    ADCSRA |= (1 << ADSC);
+}
+
+
+bool QTRSensorsAnalog::startBackgroundRead(unsigned char prescaler)
+{
+    unsigned char i;
+
+    if (_pins == 0 || _numSensors == 0)
+        return false;
+
+    if (adcOwner && (ADCSRA & (1 << ADIE)))
+        adcOwner->stopBackgroundRead();
+
+    if (_channels == 0)
+    {
+        _channels = (unsigned char*)malloc(_numSensors);
+        if (_channels == 0)
+            return false;
+    }
+    if (_latest == 0)
+    {
+        _latest = (volatile unsigned int*)malloc(sizeof(unsigned int)*_numSensors);
+        if (_latest == 0)
+            return false;
+    }
+
+    // Convert the pin numbers to ADC channels the same way analogRead()
+    // does.
+    for (i = 0; i < _numSensors; i++)
+    {
+        unsigned char pin = _pins[i];
+        if (pin >= 18)
+            pin -= 18;
+        _channels[i] = analogPinToChannel(pin);
+        _latest[i] = 0;
+    }
+    _cycleCount = 0;
+
+    if (prescaler < 2)
+        prescaler = 2;
+    if (prescaler > 7)
+        prescaler = 7;
+
+    adcChannels = _channels;
+    adcResults = _latest;
+    adcCycleCount = &_cycleCount;
+    adcCount = _numSensors;
+    adcIndex = 0;
+    adcOwner = this;
+    _background = 1;
+
+    // Wait for any conversion started by analogRead() to finish, then
+    // start the first conversion with the interrupt enabled.
+    while (ADCSRA & (1 << ADSC)) {}
+    adcSelect(_channels[0]);
+    ADCSRA = (1 << ADEN) | (1 << ADIF) | (1 << ADIE) | prescaler;
+    ADCSRA |= (1 << ADSC);
+    return true;
+}
@@ -0,0 +1,358 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file QTRSensorsStatic.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <FastGPIO.h>
+#include <QTRSensors.h>
+
+/*! \cond */
+// Switches the emitters, or does nothing if there is no emitter pin.
+template <uint8_t pin> struct QTRStaticEmitter
+{
+    static void on() { FastGPIO::Pin<pin>::setOutputHigh(); }
+    static void off() { FastGPIO::Pin<pin>::setOutputLow(); }
+};
+
+template <> struct QTRStaticEmitter<QTR_NO_EMITTER_PIN>
+{
+    static void on() { }
+    static void off() { }
+};
+/*! \endcond */
+
+/*! \brief Reads QTR-RC reflectance sensors whose pins are known at compile
+ * time, without using dynamic memory or virtual functions.
+ *
+ * This class does the same job as QTRSensorsRC and has the same functions
+ * for reading, calibrating, and finding the line, but the sensor pins and
+ * emitter pin are template parameters instead of constructor arguments:
+ *
+ * ~~~{.cpp}
+ * QTRSensorsStatic<SENSOR_LEDON, SENSOR_DOWN1, SENSOR_DOWN3, SENSOR_DOWN5>
+ *   lineSensors;
+ * ~~~
+ *
+ * This has several advantages on a microcontroller with little RAM:
+ *
+ * - The pin list and calibration arrays are sized at compile time and are
+ *   part of the object, so `malloc()` is never called and the memory used is
+ *   reported by the compiler.
+ * - There is no virtual function table.
+ * - The pins are read and written with FastGPIO, which compiles to single
+ *   instructions, instead of `digitalRead()`, `digitalWrite()`, and
+ *   `pinMode()`, so the timing loop checks the pins much more often.
+ *
+ * The disadvantage is that the pins cannot be changed while the program runs.
+ *
+ * The readings stop as soon as all of the sensors have discharged.
+ *
+ * For the Zumo 32U4, Zumo32U4LineSensorsStatic3 and
+ * Zumo32U4LineSensorsStatic5 are defined in Zumo32U4LineSensors.h.
+ *
+ * \tparam emitterPin The pin that controls the IR emitters, or
+ *   #QTR_NO_EMITTER_PIN.
+ * \tparam pins The pins of the sensors, from left to right. */
+template <uint8_t emitterPin, uint8_t... pins> class QTRSensorsStatic
+{
+public:
+
+    /*! The number of sensors. */
+    static const uint8_t sensorCount = sizeof...(pins);
+
+    /*! \brief Constructor.
+     *
+     * \param timeout The length of time in microseconds beyond which a
+     *   sensor reading is considered completely black. */
+    QTRSensorsStatic(uint16_t timeout = 2000)
+    {
+        this->timeout = timeout;
+        lastValue = 0;
+        calibratedOn = calibratedOff = false;
+    }
+
+    /*! \brief Sets the timeout in microseconds. */
+    void setTimeout(uint16_t timeout)
+    {
+        this->timeout = timeout;
+    }
+
+    /*! \brief Reads the raw sensor values, in microseconds.
+     *
+     * This works like QTRSensors::read(). */
+    void read(uint16_t * sensorValues, uint8_t readMode = QTR_EMITTERS_ON)
+    {
+        if (readMode == QTR_EMITTERS_ON || readMode == QTR_EMITTERS_ON_AND_OFF)
+        {
+            emittersOn();
+        }
+        else
+        {
+            emittersOff();
+        }
+
+        readPrivate(sensorValues);
+        emittersOff();
+
+        if (readMode == QTR_EMITTERS_ON_AND_OFF)
+        {
+            uint16_t offValues[sensorCount];
+            readPrivate(offValues);
+            for (uint8_t i = 0; i < sensorCount; i++)
+            {
+                sensorValues[i] += timeout - offValues[i];
+            }
+        }
+    }
+
+    /*! \brief Turns the IR emitters off. */
+    void emittersOff()
+    {
+        QTRStaticEmitter<emitterPin>::off();
+        delayMicroseconds(200);
+    }
+
+    /*! \brief Turns the IR emitters on. */
+    void emittersOn()
+    {
+        QTRStaticEmitter<emitterPin>::on();
+        delayMicroseconds(200);
+    }
+
+    /*! \brief Reads the sensors for calibration.
+     *
+     * This works like QTRSensors::calibrate(). */
+    void calibrate(uint8_t readMode = QTR_EMITTERS_ON)
+    {
+        if (readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_ON)
+        {
+            calibrateOnOrOff(calibratedMinimumOn, calibratedMaximumOn,
+                calibratedOn, QTR_EMITTERS_ON);
+        }
+        if (readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_OFF)
+        {
+            calibrateOnOrOff(calibratedMinimumOff, calibratedMaximumOff,
+                calibratedOff, QTR_EMITTERS_OFF);
+        }
+    }
+
+    /*! \brief Resets all calibration that has been done. */
+    void resetCalibration()
+    {
+        calibratedOn = calibratedOff = false;
+    }
+
+    /*! \brief Reads the sensors and provides calibrated values between 0 and
+     * 1000.
+     *
+     * This works like QTRSensors::readCalibrated(). */
+    void readCalibrated(uint16_t * sensorValues,
+        uint8_t readMode = QTR_EMITTERS_ON)
+    {
+        // If not calibrated, do nothing.
+        if ((readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_OFF)
+            && !calibratedOff) { return; }
+        if ((readMode == QTR_EMITTERS_ON_AND_OFF || readMode == QTR_EMITTERS_ON)
+            && !calibratedOn) { return; }
+
+        read(sensorValues, readMode);
+
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            uint16_t calmin, calmax;
+
+            if (readMode == QTR_EMITTERS_ON)
+            {
+                calmax = calibratedMaximumOn[i];
+                calmin = calibratedMinimumOn[i];
+            }
+            else if (readMode == QTR_EMITTERS_OFF)
+            {
+                calmax = calibratedMaximumOff[i];
+                calmin = calibratedMinimumOff[i];
+            }
+            else
+            {
+                if (calibratedMinimumOff[i] < calibratedMinimumOn[i])
+                {
+                    calmin = timeout;
+                }
+                else
+                {
+                    calmin = calibratedMinimumOn[i] + timeout - calibratedMinimumOff[i];
+                }
+
+                if (calibratedMaximumOff[i] < calibratedMaximumOn[i])
+                {
+                    calmax = timeout;
+                }
+                else
+                {
+                    calmax = calibratedMaximumOn[i] + timeout - calibratedMaximumOff[i];
+                }
+            }
+
+            uint16_t denominator = calmax - calmin;
+            int16_t x = 0;
+            if (denominator != 0)
+            {
+                x = ((int32_t)sensorValues[i] - calmin) * 1000 / denominator;
+            }
+            if (x < 0) { x = 0; }
+            else if (x > 1000) { x = 1000; }
+            sensorValues[i] = x;
+        }
+    }
+
+    /*! \brief Reads the sensors, provides calibrated values, and returns an
+     * estimated line position from 0 to 1000 * (#sensorCount - 1).
+     *
+     * This works like QTRSensors::readLine(). */
+    uint16_t readLine(uint16_t * sensorValues,
+        uint8_t readMode = QTR_EMITTERS_ON, bool whiteLine = false)
+    {
+        bool onLine = false;
+        uint32_t avg = 0;
+        uint16_t sum = 0;
+
+        readCalibrated(sensorValues, readMode);
+
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            uint16_t value = sensorValues[i];
+            if (whiteLine) { value = 1000 - value; }
+
+            // Keep track of whether we see the line at all.
+            if (value > 200) { onLine = true; }
+
+            // Only average in values that are above a noise threshold.
+            if (value > 50)
+            {
+                avg += (uint32_t)value * (i * 1000);
+                sum += value;
+            }
+        }
+
+        if (!onLine)
+        {
+            // If it last read to the left of center, return 0; otherwise
+            // return the max.
+            if (lastValue < (sensorCount - 1) * 1000 / 2) { return 0; }
+            return (sensorCount - 1) * 1000;
+        }
+
+        lastValue = avg / sum;
+        return lastValue;
+    }
+
+    /*! \name Calibrated minimum and maximum values
+     *
+     * These are only meaningful after calibrate() has been called with the
+     * corresponding read mode. */
+    /*! @{ */
+    uint16_t calibratedMinimumOn[sizeof...(pins)];
+    uint16_t calibratedMaximumOn[sizeof...(pins)];
+    uint16_t calibratedMinimumOff[sizeof...(pins)];
+    uint16_t calibratedMaximumOff[sizeof...(pins)];
+    /*! @} */
+
+private:
+
+    // Expands a function call for each pin.  The calls are made in order,
+    // from left to right.
+    typedef int expand[];
+
+    static void checkPin(bool high, uint16_t & value, uint16_t time,
+        uint8_t & remaining)
+    {
+        if (!high && time < value)
+        {
+            value = time;
+            remaining--;
+        }
+    }
+
+    void readPrivate(uint16_t * sensorValues)
+    {
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            sensorValues[i] = timeout;
+        }
+
+        // Charge the sensor lines.
+        (void)expand{ (FastGPIO::Pin<pins>::setOutputHigh(), 0)... };
+        delayMicroseconds(10);
+
+        // Make the lines inputs with the pull-ups disabled and time how long
+        // each one takes to discharge.
+        (void)expand{ (FastGPIO::Pin<pins>::setInput(), 0)... };
+
+        uint8_t remaining = sensorCount;
+        uint32_t start = micros();
+        while (remaining)
+        {
+            uint32_t elapsed = micros() - start;
+            if (elapsed >= timeout) { break; }
+            uint16_t time = elapsed;
+            uint8_t i = 0;
+            (void)expand{ (checkPin(FastGPIO::Pin<pins>::isInputHigh(),
+                sensorValues[i++], time, remaining), 0)... };
+        }
+    }
+
+    void calibrateOnOrOff(uint16_t * calibratedMinimum,
+        uint16_t * calibratedMaximum, bool & calibrated, uint8_t readMode)
+    {
+        uint16_t sensorValues[sensorCount];
+        uint16_t maxSensorValues[sensorCount];
+        uint16_t minSensorValues[sensorCount];
+
+        if (!calibrated)
+        {
+            // Initialize the limits to values that the first reading will
+            // update.
+            for (uint8_t i = 0; i < sensorCount; i++)
+            {
+                calibratedMaximum[i] = 0;
+                calibratedMinimum[i] = timeout;
+            }
+            calibrated = true;
+        }
+
+        for (uint8_t j = 0; j < 10; j++)
+        {
+            read(sensorValues, readMode);
+            for (uint8_t i = 0; i < sensorCount; i++)
+            {
+                if (j == 0 || maxSensorValues[i] < sensorValues[i])
+                {
+                    maxSensorValues[i] = sensorValues[i];
+                }
+                if (j == 0 || minSensorValues[i] > sensorValues[i])
+                {
+                    minSensorValues[i] = sensorValues[i];
+                }
+            }
+        }
+
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            if (minSensorValues[i] > calibratedMaximum[i])
+            {
+                calibratedMaximum[i] = minSensorValues[i];
+            }
+            if (maxSensorValues[i] < calibratedMinimum[i])
+            {
+                calibratedMinimum[i] = maxSensorValues[i];
+            }
+        }
+    }
+
+    uint16_t timeout;
+    uint16_t lastValue;
+    bool calibratedOn;
+    bool calibratedOff;
+};
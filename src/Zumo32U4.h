@@ -14,16 +14,32 @@
 #endif
 
 #include <FastGPIO.h>
+#include <Zumo32U4Brake.h>
 #include <Zumo32U4Buttons.h>
 #include <Zumo32U4Buzzer.h>
+#include <Zumo32U4CollisionDetector.h>
+#include <Zumo32U4Compass.h>
+#include <Zumo32U4Drive.h>
 #include <Zumo32U4Encoders.h>
+#include <Zumo32U4FlightRecorder.h>
 #include <Zumo32U4IMU.h>
 #include <Zumo32U4IRPulses.h>
 #include <Zumo32U4LCD.h>
+#include <Zumo32U4LineFeatures.h>
 #include <Zumo32U4LineSensors.h>
+#include <Zumo32U4LoopProfiler.h>
+#include <Zumo32U4MotionProfile.h>
 #include <Zumo32U4Motors.h>
 #include <Zumo32U4OLED.h>
+#include <Zumo32U4Odometry.h>
 #include <Zumo32U4ProximitySensors.h>
+#include <Zumo32U4ProximitySensorsStatic.h>
+#include <Zumo32U4Scheduler.h>
+#include <Zumo32U4StallDetector.h>
+#include <Zumo32U4Telemetry.h>
+#include <Zumo32U4TiltMonitor.h>
+#include <Zumo32U4Timebase.h>
+#include <Zumo32U4Trig.h>
 
 // TODO: servo support
 
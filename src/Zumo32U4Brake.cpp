@@ -0,0 +1,179 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Brake.h>
+#include <Zumo32U4Encoders.h>
+#include <Zumo32U4Motors.h>
+#include <Arduino.h>
+
+// How long both tracks must be still before braking is over, in ms.
+static const uint16_t stillTime = 20;
+
+Zumo32U4Brake::Zumo32U4Brake()
+{
+    setGains(32, 32);
+    state = State::Idle;
+    stoppingDistance = 0;
+}
+
+void Zumo32U4Brake::setGains(uint16_t damping, uint16_t stiffness)
+{
+    this->damping = damping;
+    this->stiffness = stiffness;
+}
+
+void Zumo32U4Brake::brake(uint16_t maxMs)
+{
+    start(State::Idle, maxMs);
+}
+
+void Zumo32U4Brake::hold()
+{
+    start(State::Holding, 0xFFFF);
+}
+
+void Zumo32U4Brake::brakeThenReverse(int16_t speed, uint16_t reverseMs,
+    uint16_t maxBrakeMs)
+{
+    reverseSpeed = speed;
+    this->reverseMs = reverseMs;
+    start(State::Reversing, maxBrakeMs);
+}
+
+void Zumo32U4Brake::start(State next, uint16_t maxBrakeMs)
+{
+    lastCountsLeft = Zumo32U4Encoders::getCountsLeft();
+    lastCountsRight = Zumo32U4Encoders::getCountsRight();
+    positionLeft = positionRight = 0;
+    stillLeft = stillRight = 0;
+    stoppingDistance = 0;
+    stillMs = 0;
+
+    this->next = next;
+    this->maxBrakeMs = maxBrakeMs;
+    startMs = lastUpdateMs = millis();
+    state = State::Braking;
+
+    // Until the first update, use the passive brake.
+    Zumo32U4Motors::setSpeeds(0, 0);
+}
+
+void Zumo32U4Brake::update()
+{
+    if (state == State::Idle) { return; }
+
+    // Measure the track speeds over at least 2 ms so that a single encoder
+    // count does not look like a high speed.
+    uint16_t now = millis();
+    uint16_t dt = now - lastUpdateMs;
+    if (dt < 2) { return; }
+    lastUpdateMs = now;
+
+    if (state == State::Reversing)
+    {
+        if ((uint16_t)(now - startMs) >= reverseMs) { finish(); }
+        return;
+    }
+
+    // These differences are done with unsigned numbers because signed
+    // integer overflow is undefined behavior in C++.
+    int16_t countsLeft = Zumo32U4Encoders::getCountsLeft();
+    int16_t countsRight = Zumo32U4Encoders::getCountsRight();
+    int16_t deltaLeft = (uint16_t)countsLeft - (uint16_t)lastCountsLeft;
+    int16_t deltaRight = (uint16_t)countsRight - (uint16_t)lastCountsRight;
+    lastCountsLeft = countsLeft;
+    lastCountsRight = countsRight;
+    positionLeft += deltaLeft;
+    positionRight += deltaRight;
+
+    if (state == State::Holding)
+    {
+        Zumo32U4Motors::setSpeeds(
+            brakeTrack(deltaLeft, dt, positionLeft - holdLeft),
+            brakeTrack(deltaRight, dt, positionRight - holdRight));
+        return;
+    }
+
+    // Braking.
+    Zumo32U4Motors::setSpeeds(brakeTrack(deltaLeft, dt, 0),
+        brakeTrack(deltaRight, dt, 0));
+
+    int32_t distance = (labs(positionLeft) + labs(positionRight)) / 2;
+    stoppingDistance = distance > 0xFFFF ? 0xFFFF : distance;
+
+    // The tracks are still once neither has moved more than one count away
+    // from where it was stillTime ago.  Comparing against a position
+    // instead of each delta makes the test the same however often update()
+    // is called, while one count still allows for an encoder sitting on the
+    // edge between two counts.
+    if (labs(positionLeft - stillLeft) <= 1 &&
+        labs(positionRight - stillRight) <= 1)
+    {
+        stillMs += dt;
+    }
+    else
+    {
+        stillLeft = positionLeft;
+        stillRight = positionRight;
+        stillMs = 0;
+    }
+
+    if (stillMs >= stillTime || (uint16_t)(now - startMs) >= maxBrakeMs)
+    {
+        endBraking(now);
+    }
+}
+
+int16_t Zumo32U4Brake::brakeTrack(int16_t delta, uint16_t dt, int32_t offset)
+{
+    // The speed of the track in counts per second.  A change of one count
+    // could just be the encoder sitting on the edge between two counts, so
+    // it is ignored.
+    int32_t velocity = 0;
+    if (abs(delta) > 1)
+    {
+        velocity = (int32_t)delta * 1000 / dt;
+    }
+
+    int32_t speed = -(velocity * damping / 256) - offset * stiffness / 16;
+
+    int16_t max = Zumo32U4Motors::getMaxSpeed();
+    if (speed > max) { speed = max; }
+    if (speed < -max) { speed = -max; }
+    return speed;
+}
+
+void Zumo32U4Brake::endBraking(uint16_t now)
+{
+    switch (next)
+    {
+    case State::Holding:
+        holdLeft = positionLeft;
+        holdRight = positionRight;
+        state = State::Holding;
+        break;
+
+    case State::Reversing:
+        Zumo32U4Motors::setSpeeds(reverseSpeed, reverseSpeed);
+        startMs = now;
+        state = State::Reversing;
+        break;
+
+    default:
+        finish();
+        break;
+    }
+}
+
+void Zumo32U4Brake::stop()
+{
+    if (state != State::Idle)
+    {
+        finish();
+    }
+}
+
+void Zumo32U4Brake::finish()
+{
+    Zumo32U4Motors::setSpeeds(0, 0);
+    state = State::Idle;
+}
@@ -0,0 +1,153 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Brake.h */
+
+#pragma once
+
+#include <stdint.h>
+
+/*! \brief Stops the robot quickly by driving the motors against the motion
+ * measured by the encoders.
+ *
+ * On the Zumo 32U4, a speed of 0 already brakes the motors: the DRV8838
+ * drivers short the motor terminals together when their enable input is low.
+ * (The drivers' sleep inputs are not connected to the microcontroller, so
+ * the motors cannot be set to coast.)  That kind of braking gets weaker as
+ * the motors slow down, so the robot still slides for a while.
+ *
+ * This class brakes actively: it reads the encoders and sets each motor to a
+ * speed that opposes the motion of its track, in proportion to the speed of
+ * the track.  With hold(), once the robot has stopped, it also holds the
+ * tracks at that position, which resists being pushed.
+ *
+ * Like Zumo32U4Drive, each maneuver starts with a function call and then
+ * runs in the background while you call update():
+ *
+ * ~~~{.cpp}
+ * Zumo32U4Brake brake;
+ *
+ * // When the border is seen:
+ * brake.brakeThenReverse(-200, 200);
+ * while (!brake.isDone())
+ * {
+ *   brake.update();
+ * }
+ * ~~~
+ *
+ * This class assumes that positive motor speeds make the encoder counts
+ * increase, which is true unless a motor has been flipped with
+ * Zumo32U4Motors::flipLeftMotor() or Zumo32U4Motors::flipRightMotor().
+ *
+ * The BrakeTest example compares the stopping distance with and without
+ * active braking. */
+class Zumo32U4Brake
+{
+public:
+
+    Zumo32U4Brake();
+
+    /*! \brief Sets the gains of the controller.
+     *
+     * \param damping The motor speed (as passed to Zumo32U4Motors::setSpeeds())
+     *   applied against each encoder count per second of track speed, times
+     *   256.  The default is 32, so a track moving at 3200 counts per second
+     *   gets a speed of 400 against it.
+     * \param stiffness The motor speed applied for each encoder count that a
+     *   stopped track is pushed from its position, times 16.  The default is
+     *   32. */
+    void setGains(uint16_t damping, uint16_t stiffness);
+
+    /*! \brief Starts braking until both tracks have stopped.
+     *
+     * The maneuver is done when neither track has moved more than one
+     * encoder count in 20 ms, or after \p maxMs milliseconds, whichever comes
+     * first.  The motor speeds are then set to 0. */
+    void brake(uint16_t maxMs = 300);
+
+    /*! \brief Starts braking and then holds the tracks in place until stop()
+     * is called. */
+    void hold();
+
+    /*! \brief Starts braking, then drives both motors at the specified speed
+     * for the specified time.
+     *
+     * \param speed The speed to drive at after braking, as passed to
+     *   Zumo32U4Motors::setSpeeds().  This is usually negative, to back
+     *   away from something.
+     * \param reverseMs How long to drive at that speed, in milliseconds.
+     * \param maxBrakeMs The maximum time to spend braking, in milliseconds. */
+    void brakeThenReverse(int16_t speed, uint16_t reverseMs,
+        uint16_t maxBrakeMs = 300);
+
+    /*! \brief Runs the maneuver.
+     *
+     * This should be called as often as possible, ideally at least every
+     * 2 ms, while a maneuver is running, because the braking force depends on
+     * the track speeds measured between calls.  When no maneuver is running,
+     * it does nothing. */
+    void update();
+
+    /*! \brief Ends the current maneuver and sets the motor speeds to 0. */
+    void stop();
+
+    /*! \brief Returns true if no maneuver is running. */
+    bool isDone() const
+    {
+        return state == State::Idle;
+    }
+
+    /*! \brief Returns how far the robot traveled after braking started and
+     * before it stopped, in encoder counts.
+     *
+     * This is the average of the distances traveled by the two tracks, and
+     * it is updated until the braking phase of the maneuver is over. */
+    uint16_t getStoppingDistance() const
+    {
+        return stoppingDistance;
+    }
+
+private:
+
+    enum class State : uint8_t
+    {
+        Idle,
+        Braking,
+        Holding,
+        Reversing,
+    };
+
+    // Returns the motor speed for one track, given the change in its
+    // encoder count over dt milliseconds and how far it has been pushed from
+    // where it is being held.
+    int16_t brakeTrack(int16_t delta, uint16_t dt, int32_t offset);
+
+    void start(State next, uint16_t maxBrakeMs);
+
+    // Goes to the next state after braking.
+    void endBraking(uint16_t now);
+
+    void finish();
+
+    uint16_t damping;
+    uint16_t stiffness;
+
+    State state;
+    State next;  // What to do after braking.
+    int16_t reverseSpeed;
+    uint16_t reverseMs;
+    uint16_t maxBrakeMs;
+
+    uint16_t startMs;
+    uint16_t lastUpdateMs;
+    uint16_t stillMs;
+    int32_t stillLeft;   // The positions when the tracks became still.
+    int32_t stillRight;
+
+    int16_t lastCountsLeft;
+    int16_t lastCountsRight;
+    int32_t positionLeft;
+    int32_t positionRight;
+    int32_t holdLeft;
+    int32_t holdRight;
+    uint16_t stoppingDistance;
+};
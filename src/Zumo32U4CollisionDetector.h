@@ -0,0 +1,238 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4CollisionDetector.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Zumo32U4IMU.h>
+#include <Zumo32U4Trig.h>
+
+/*! \brief Detects impacts, such as contact with an opponent in a sumo ring,
+ * with the accelerometer.
+ *
+ * This class averages the last few readings of the X and Y axes of the
+ * accelerometer and reports an impact when the length of the average vector
+ * goes over a threshold.  It is the detector from the SumoCollisionDetect
+ * example, written with integer math: the length is compared as a square, so
+ * no square root is needed, and the window of readings is a fixed array, so
+ * no memory is allocated.  Each reading takes a few dozen microseconds to
+ * process, so the detector can keep up with the accelerometer at its highest
+ * useful data rate (see Zumo32U4IMU::configureForCollisionDetection()).
+ *
+ * ~~~{.cpp}
+ * Zumo32U4IMU imu;
+ * Zumo32U4CollisionDetector<> collisionDetector;
+ *
+ * void loop()
+ * {
+ *   if (collisionDetector.update(imu))
+ *   {
+ *     if (collisionDetector.getImpactSide() ==
+ *       Zumo32U4CollisionDetector<>::Side::Front) { ... }
+ *   }
+ * }
+ * ~~~
+ *
+ * The robot's own acceleration also shows up on the accelerometer, so you
+ * should call ignoreFor() when it starts, stops, or turns sharply.  After
+ * each impact, further impacts are ignored for the time set with
+ * setMinInterval().
+ *
+ * This class assumes that the accelerometer's X axis points forward and its
+ * Y axis points left, as they do on the Zumo 32U4.
+ *
+ * \tparam averageSize The number of readings to average.  Each reading uses
+ * 4 bytes of RAM. */
+template <uint8_t averageSize = 3> class Zumo32U4CollisionDetector
+{
+public:
+
+    /*! The side of the robot that an impact came from. */
+    enum class Side : uint8_t
+    {
+        Front,
+        Left,
+        Back,
+        Right,
+    };
+
+    Zumo32U4CollisionDetector()
+    {
+        setThreshold(2400);
+        setMinInterval(1000);
+        reset();
+    }
+
+    /*! \brief Sets the length of the average X-Y acceleration above which an
+     * impact is reported.
+     *
+     * The default, 2400, is about 0.15 g when the accelerometer is set to
+     * +/- 2 g full scale, where gravity reads about 16000. */
+    void setThreshold(uint16_t threshold)
+    {
+        thresholdSquared = (uint32_t)threshold * threshold;
+    }
+
+    /*! \brief Sets how long to ignore the accelerometer after each impact, in
+     * milliseconds.  The default is 1000. */
+    void setMinInterval(uint16_t ms)
+    {
+        minInterval = ms;
+    }
+
+    /*! \brief Ignores the accelerometer for the specified time, in
+     * milliseconds.
+     *
+     * Call this when the robot turns or changes speed, because its own
+     * acceleration could look like an impact.  If impacts are already being
+     * ignored for longer than that, this does nothing. */
+    void ignoreFor(uint16_t ms)
+    {
+        uint16_t now = millis();
+        if (ms > remainingHoldoff(now))
+        {
+            holdoffStartMs = now;
+            holdoffMs = ms;
+        }
+    }
+
+    /*! \brief Clears the readings and the time to ignore. */
+    void reset()
+    {
+        for (uint8_t i = 0; i < averageSize; i++)
+        {
+            readings[i].x = readings[i].y = 0;
+        }
+        sumX = sumY = 0;
+        index = 0;
+        count = 0;
+        holdoffMs = 0;
+        impactX = impactY = 0;
+    }
+
+    /*! \brief Reads the accelerometer if it has new data and checks for an
+     * impact.
+     *
+     * This should be called as often as possible so that no readings are
+     * missed.  It takes one I2C transaction to check for new data and, if
+     * there is some, one burst read of the three axes.
+     *
+     * \return True if an impact was detected. */
+    bool update(Zumo32U4IMU & imu)
+    {
+        if (!imu.accDataReady()) { return false; }
+        imu.readAcc();
+        return addReading(imu.a.x, imu.a.y);
+    }
+
+    /*! \brief Adds a reading of the X and Y axes of the accelerometer and
+     * checks for an impact.
+     *
+     * Use this instead of update() if your code already reads the
+     * accelerometer.
+     *
+     * \return True if an impact was detected. */
+    bool addReading(int16_t x, int16_t y)
+    {
+        // Replace the oldest reading in the window.
+        Reading & r = readings[index];
+        sumX += x - r.x;
+        sumY += y - r.y;
+        r.x = x;
+        r.y = y;
+        if (++index >= averageSize) { index = 0; }
+        if (count < averageSize)
+        {
+            count++;
+            return false;
+        }
+
+        int16_t averageX = sumX / averageSize;
+        int16_t averageY = sumY / averageSize;
+        uint32_t lengthSquared = (int32_t)averageX * averageX +
+            (int32_t)averageY * averageY;
+        if (lengthSquared <= thresholdSquared) { return false; }
+
+        uint16_t now = millis();
+        if (remainingHoldoff(now)) { return false; }
+
+        impactX = averageX;
+        impactY = averageY;
+        impactMs = now;
+        holdoffStartMs = now;
+        holdoffMs = minInterval;
+        return true;
+    }
+
+    /*! \brief Returns the direction that the last impact came from.
+     *
+     * The direction is an angle where 0 is straight ahead, 0x4000 is to the
+     * left, and 65536 would be a full turn, as used by Zumo32U4Trig.  It is
+     * opposite to the acceleration: hitting something in front of the robot
+     * pushes the robot backwards. */
+    uint16_t getImpactDirection() const
+    {
+        return Zumo32U4Trig::arctangent(-impactY, -impactX);
+    }
+
+    /*! \brief Returns the side of the robot that the last impact came from.
+     *
+     * Each side covers 90 degrees, centered on the direction it faces. */
+    Side getImpactSide() const
+    {
+        return (Side)((uint16_t)(getImpactDirection() + 0x2000) >> 14);
+    }
+
+    /*! \brief Returns the length of the average X-Y acceleration at the last
+     * impact, in the same units as the threshold. */
+    uint16_t getImpactMagnitude() const
+    {
+        return Zumo32U4Trig::magnitude(impactX, impactY);
+    }
+
+    /*! \brief Returns the value of `millis()`, truncated to 16 bits, when the
+     * last impact was detected. */
+    uint16_t getImpactTime() const
+    {
+        return impactMs;
+    }
+
+private:
+
+    struct Reading
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    // Returns how many more milliseconds impacts are ignored for.
+    uint16_t remainingHoldoff(uint16_t now)
+    {
+        uint16_t elapsed = now - holdoffStartMs;
+        if (elapsed >= holdoffMs)
+        {
+            // Forget the old start time so that it does not look recent when
+            // millis() wraps around.
+            holdoffMs = 0;
+            return 0;
+        }
+        return holdoffMs - elapsed;
+    }
+
+    Reading readings[averageSize];
+    int32_t sumX;
+    int32_t sumY;
+    uint8_t index;
+    uint8_t count;
+
+    uint32_t thresholdSquared;
+    uint16_t minInterval;
+    uint16_t holdoffStartMs;
+    uint16_t holdoffMs;
+
+    int16_t impactX;
+    int16_t impactY;
+    uint16_t impactMs;
+};
@@ -0,0 +1,147 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Compass.h>
+#include <Zumo32U4IMU.h>
+#include <Zumo32U4Motors.h>
+#include <Zumo32U4Trig.h>
+#include <Arduino.h>
+
+// The smallest half-range of the X and Y readings that counts as a
+// calibration.  The Earth's field gives half-ranges of a few thousand.
+static const int32_t minHalfRange = 200;
+
+// Corrected readings are limited to this so that the products in heading()
+// fit in 32 bits.
+static const int16_t maxCorrected = 16383;
+
+Zumo32U4Compass::Zumo32U4Compass()
+{
+    calibration.offsetX = calibration.offsetY = calibration.offsetZ = 0;
+    calibration.scaleX = calibration.scaleY = calibration.scaleZ = 4096;
+    startCalibration();
+}
+
+bool Zumo32U4Compass::calibrate(Zumo32U4IMU & imu, int16_t spinSpeed,
+    uint16_t durationMs)
+{
+    startCalibration();
+    Zumo32U4Motors::setSpeeds(-spinSpeed, spinSpeed);
+    uint16_t startMs = millis();
+    while ((uint16_t)(millis() - startMs) < durationMs)
+    {
+        if (imu.magDataReady())
+        {
+            imu.readMag();
+            addCalibrationReading(imu.m.x, imu.m.y, imu.m.z);
+        }
+    }
+    Zumo32U4Motors::setSpeeds(0, 0);
+    return finishCalibration();
+}
+
+void Zumo32U4Compass::startCalibration()
+{
+    minX = minY = minZ = 32767;
+    maxX = maxY = maxZ = -32768;
+}
+
+void Zumo32U4Compass::addCalibrationReading(int16_t x, int16_t y, int16_t z)
+{
+    if (x < minX) { minX = x; }
+    if (x > maxX) { maxX = x; }
+    if (y < minY) { minY = y; }
+    if (y > maxY) { maxY = y; }
+    if (z < minZ) { minZ = z; }
+    if (z > maxZ) { maxZ = z; }
+}
+
+// Returns the scale that makes a half-range as big as the radius.
+static uint16_t scaleFor(int32_t radius, int32_t halfRange)
+{
+    int32_t scale = radius * 4096 / halfRange;
+    return scale > 0xFFFF ? 0xFFFF : scale;
+}
+
+bool Zumo32U4Compass::finishCalibration()
+{
+    int32_t halfX = ((int32_t)maxX - minX) / 2;
+    int32_t halfY = ((int32_t)maxY - minY) / 2;
+    int32_t halfZ = ((int32_t)maxZ - minZ) / 2;
+    if (halfX < minHalfRange || halfY < minHalfRange) { return false; }
+
+    // Scale every axis to the average of the X and Y half-ranges, so the
+    // corrected readings are about as big as the raw ones.
+    int32_t radius = (halfX + halfY) / 2;
+
+    calibration.offsetX = ((int32_t)maxX + minX) / 2;
+    calibration.offsetY = ((int32_t)maxY + minY) / 2;
+    calibration.scaleX = scaleFor(radius, halfX);
+    calibration.scaleY = scaleFor(radius, halfY);
+
+    if (halfZ >= radius / 2)
+    {
+        calibration.offsetZ = ((int32_t)maxZ + minZ) / 2;
+        calibration.scaleZ = scaleFor(radius, halfZ);
+    }
+    else
+    {
+        calibration.offsetZ = 0;
+        calibration.scaleZ = ((uint32_t)calibration.scaleX +
+            calibration.scaleY) / 2;
+    }
+    return true;
+}
+
+int16_t Zumo32U4Compass::correct(int16_t raw, int16_t offset, uint16_t scale)
+{
+    int32_t result = ((int32_t)raw - offset) * scale / 4096;
+    if (result > maxCorrected) { result = maxCorrected; }
+    if (result < -maxCorrected) { result = -maxCorrected; }
+    return result;
+}
+
+uint16_t Zumo32U4Compass::heading(const Zumo32U4IMU & imu) const
+{
+    return heading(imu.m.x, imu.m.y, imu.m.z, imu.a.x, imu.a.y, imu.a.z);
+}
+
+uint16_t Zumo32U4Compass::heading(int16_t mx, int16_t my, int16_t mz,
+    int16_t ax, int16_t ay, int16_t az) const
+{
+    int16_t x = correct(mx, calibration.offsetX, calibration.scaleX);
+    int16_t y = correct(my, calibration.offsetY, calibration.scaleY);
+    int16_t z = correct(mz, calibration.offsetZ, calibration.scaleZ);
+
+    // Only the direction of the acceleration matters, so drop two bits to
+    // keep the products below in 32 bits.
+    ax /= 4;
+    ay /= 4;
+    az /= 4;
+    uint16_t length = Zumo32U4Trig::squareRoot(
+        (uint32_t)((int32_t)ax * ax) + (uint32_t)((int32_t)ay * ay) +
+        (uint32_t)((int32_t)az * az));
+    if (length == 0) { return heading(mx, my); }
+
+    // Project the field onto the horizontal plane.  With the acceleration A
+    // pointing up and the field M, east is M x A, west is A x M, and north is
+    // A x (M x A), which is |A| times longer than west.  The heading is the
+    // angle of the robot's X axis from north toward west, so we need the X
+    // components of west and of north divided by |A|.
+    int32_t dot = (int32_t)x * ax + (int32_t)y * ay + (int32_t)z * az;
+    int32_t west = (int32_t)z * ay - (int32_t)y * az;
+    int32_t north = (int32_t)x * length - (int32_t)ax * (dot / length);
+
+    while (west > 32767 || west < -32767 || north > 32767 || north < -32767)
+    {
+        west /= 2;
+        north /= 2;
+    }
+    return Zumo32U4Trig::arctangent(west, north);
+}
+
+uint16_t Zumo32U4Compass::heading(int16_t mx, int16_t my) const
+{
+    int16_t x = correct(mx, calibration.offsetX, calibration.scaleX);
+    int16_t y = correct(my, calibration.offsetY, calibration.scaleY);
+    return Zumo32U4Trig::arctangent(-y, x);
+}
@@ -0,0 +1,150 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Compass.h */
+
+#pragma once
+
+#include <stdint.h>
+
+class Zumo32U4IMU;
+
+/*! \brief Calibrates the magnetometer and computes a compass heading from
+ * it.
+ *
+ * The magnetometer on the Zumo 32U4 sits close to the motors, whose magnets
+ * add a large constant field to its readings (hard-iron distortion), and the
+ * steel parts of the robot stretch the field more along some axes than
+ * others (soft-iron distortion).  To calibrate it, this class records the
+ * smallest and largest reading of each axis while the robot spins in place.
+ * The middle of each range is the hard-iron offset, and the size of each
+ * range gives a scale factor that makes all of the ranges the same size.
+ *
+ * ~~~{.cpp}
+ * Zumo32U4IMU imu;
+ * Zumo32U4Compass compass;
+ *
+ * void setup()
+ * {
+ *   // ... initialize the IMU ...
+ *   compass.calibrate(imu);   // spins the robot for 5 seconds
+ * }
+ *
+ * void loop()
+ * {
+ *   imu.readAcc();
+ *   imu.readMag();
+ *   uint16_t heading = compass.heading(imu);
+ * }
+ * ~~~
+ *
+ * The calibration is a #Calibration structure of 12 bytes, which you can
+ * save in EEPROM with `EEPROM.put()` and give back to setCalibration() later
+ * instead of calibrating every time.
+ *
+ * Headings are computed with integer math, using Zumo32U4Trig, so they take
+ * a few hundred microseconds instead of the milliseconds that the
+ * floating-point version would take.  A heading is an angle where 65536 is a
+ * full turn, measured counter-clockwise from magnetic north to the front of
+ * the robot, like the headings of Zumo32U4Odometry and Zumo32U4Trig.  (A
+ * compass bearing, which is measured clockwise, is the negative of that.)
+ *
+ * This class assumes that the X axes of the magnetometer and accelerometer
+ * point forward, their Y axes point left, and their Z axes point up, as they
+ * do on the Zumo 32U4. */
+class Zumo32U4Compass
+{
+public:
+
+    /*! \brief The offsets and scale factors that correct the magnetometer
+     * readings.
+     *
+     * Each corrected reading is the raw reading minus the offset, times the
+     * scale divided by 4096. */
+    struct Calibration
+    {
+        int16_t offsetX;
+        int16_t offsetY;
+        int16_t offsetZ;
+        uint16_t scaleX;
+        uint16_t scaleY;
+        uint16_t scaleZ;
+    };
+
+    Zumo32U4Compass();
+
+    /*! \brief Spins the robot in place while calibrating.
+     *
+     * This starts the motors with Zumo32U4Motors, collects magnetometer
+     * readings for the specified time, stops the motors, and calls
+     * finishCalibration().  The robot should make at least one full turn, on
+     * a level surface, away from other magnets and large pieces of steel.
+     *
+     * \param imu The IMU, which must be initialized and enabled.
+     * \param spinSpeed The speed of the motors, as passed to
+     *   Zumo32U4Motors::setSpeeds().  Positive speeds turn counter-clockwise.
+     * \param durationMs How long to spin, in milliseconds.
+     * \return The return value of finishCalibration(). */
+    bool calibrate(Zumo32U4IMU & imu, int16_t spinSpeed = 200,
+        uint16_t durationMs = 5000);
+
+    /*! \brief Starts collecting readings for a new calibration.
+     *
+     * Use this, addCalibrationReading(), and finishCalibration() instead of
+     * calibrate() if you want to move the robot yourself. */
+    void startCalibration();
+
+    /*! \brief Adds a raw magnetometer reading to the calibration. */
+    void addCalibrationReading(int16_t x, int16_t y, int16_t z);
+
+    /*! \brief Computes the calibration from the readings collected since
+     * startCalibration().
+     *
+     * The Z axis only changes much if the robot is tilted, so if its range is
+     * less than half of the range of the X and Y axes, its offset is set to 0
+     * and its scale to the average of the other two.  In that case, headings
+     * are accurate when the robot is level, but less so when it is tilted.
+     *
+     * \return False if the ranges of the X and Y axes were too small, which
+     *   usually means that the robot did not turn, in which case the old
+     *   calibration is kept. */
+    bool finishCalibration();
+
+    /*! \brief Returns the current calibration. */
+    const Calibration & getCalibration() const
+    {
+        return calibration;
+    }
+
+    /*! \brief Replaces the current calibration, for example with one that was
+     * saved in EEPROM. */
+    void setCalibration(const Calibration & calibration)
+    {
+        this->calibration = calibration;
+    }
+
+    /*! \brief Returns the heading, using the last accelerometer and
+     * magnetometer readings of the IMU (Zumo32U4IMU::a and Zumo32U4IMU::m).
+     *
+     * The accelerometer tells which way is up, so the heading is right even
+     * when the robot is tilted, as long as it is not accelerating much. */
+    uint16_t heading(const Zumo32U4IMU & imu) const;
+
+    /*! \brief Returns the heading, given raw magnetometer and accelerometer
+     * readings. */
+    uint16_t heading(int16_t mx, int16_t my, int16_t mz,
+        int16_t ax, int16_t ay, int16_t az) const;
+
+    /*! \brief Returns the heading, given the raw X and Y magnetometer
+     * readings, assuming that the robot is level. */
+    uint16_t heading(int16_t mx, int16_t my) const;
+
+private:
+
+    // Returns a reading corrected with the given offset and scale.
+    static int16_t correct(int16_t raw, int16_t offset, uint16_t scale);
+
+    Calibration calibration;
+
+    int16_t minX, minY, minZ;
+    int16_t maxX, maxY, maxZ;
+};
@@ -0,0 +1,248 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Drive.h>
+#include <Zumo32U4Encoders.h>
+#include <Zumo32U4Motors.h>
+#include <Arduino.h>
+
+// Converts a length in millimeters (or a speed in mm/s, and so on) to
+// encoder counts.  The meters and the remaining millimeters are converted
+// separately so that the products fit in 32 bits.
+static int32_t mmToCounts(int32_t mm, uint16_t countsPerMeter)
+{
+    return mm / 1000 * countsPerMeter + mm % 1000 * countsPerMeter / 1000;
+}
+
+// Returns x times ratio / 65536, where ratio is between -65536 and 65536.
+// The high and low halves of x are multiplied separately so that the
+// products fit in 32 bits.
+static int32_t multiplyQ16(int32_t x, int32_t ratio)
+{
+    uint32_t a = labs(x);
+    uint32_t r = labs(ratio);
+    uint32_t result = (a >> 16) * r + ((a & 0xFFFF) * r >> 16);
+    return ((x < 0) != (ratio < 0)) ? -(int32_t)result : (int32_t)result;
+}
+
+Zumo32U4Drive::Zumo32U4Drive()
+{
+    setGeometry(7425, 85);
+    setSpeedLimits(300, 1000);
+    setGains(14, 48);
+    setTolerance(8, 250);
+    setTimeout(0);
+    heading = NULL;
+    status = Status::Done;
+}
+
+void Zumo32U4Drive::setGeometry(uint16_t countsPerMeter, uint16_t trackWidthMm)
+{
+    this->countsPerMeter = countsPerMeter;
+    this->trackWidthMm = trackWidthMm;
+}
+
+void Zumo32U4Drive::setSpeedLimits(uint16_t speed, uint16_t acceleration,
+    uint32_t jerk)
+{
+    if (jerk > 60000) { jerk = 60000; }
+    maxSpeed = speed;
+    maxAcceleration = acceleration;
+    maxJerk = jerk;
+}
+
+void Zumo32U4Drive::setGains(uint16_t feedForward, uint16_t proportional)
+{
+    this->feedForward = feedForward;
+    this->proportional = proportional;
+}
+
+void Zumo32U4Drive::setTolerance(uint16_t counts, uint16_t settleMs)
+{
+    tolerance = counts;
+    this->settleMs = settleMs;
+}
+
+void Zumo32U4Drive::setTimeout(uint16_t timeoutMs)
+{
+    this->timeoutMs = timeoutMs;
+}
+
+void Zumo32U4Drive::setHeadingSource(const uint32_t * heading)
+{
+    this->heading = heading;
+}
+
+void Zumo32U4Drive::driveDistance(int16_t distanceMm)
+{
+    start(mmToCounts(distanceMm, countsPerMeter), 0);
+}
+
+void Zumo32U4Drive::turnAngle(int16_t angleDegrees)
+{
+    arc(0, angleDegrees);
+}
+
+void Zumo32U4Drive::arc(int16_t radiusMm, int16_t angleDegrees)
+{
+    // The distance along an arc is the radius times the angle in radians.
+    // Each track travels half of the track width farther (or less far) than
+    // the center of the robot.  71/4068 is close to pi/180.
+    int32_t angle = angleDegrees;
+    int32_t forwardMm = (int64_t)radiusMm * labs(angle) * 71 / 4068;
+    int32_t rotationMm = (int64_t)trackWidthMm * angle * 71 / (4068 * 2);
+    start(mmToCounts(forwardMm, countsPerMeter),
+        mmToCounts(rotationMm, countsPerMeter));
+}
+
+void Zumo32U4Drive::start(int32_t forward, int32_t rotation)
+{
+    lastCountsLeft = Zumo32U4Encoders::getCountsLeft();
+    lastCountsRight = Zumo32U4Encoders::getCountsRight();
+    left = right = 0;
+    if (heading != NULL) { lastHeading = *heading; }
+    headingTotal = 0;
+
+    targetForward = forward;
+    targetRotation = rotation;
+
+    // The profile is for the faster track, which travels the forward
+    // distance plus the extra distance from the rotation.
+    pathLength = labs(forward) + labs(rotation);
+
+    // Work out the parts of the path that are forward and rotation as
+    // fractions with 16 bits after the point, so that update() does not
+    // need to divide.
+    if (pathLength != 0)
+    {
+        forwardRatio = ((int64_t)forward << 16) / pathLength;
+        rotationRatio = ((int64_t)rotation << 16) / pathLength;
+    }
+    else
+    {
+        forwardRatio = rotationRatio = 0;
+    }
+
+    // A full turn of the heading moves each track pi times the track width,
+    // in encoder counts.  355/113 is close to pi.
+    countsPerTurn = mmToCounts(trackWidthMm, countsPerMeter) * 355 / 113;
+
+    profile.setLimits(mmToCounts(maxSpeed, countsPerMeter),
+        mmToCounts(maxAcceleration, countsPerMeter),
+        mmToCounts(maxJerk, countsPerMeter));
+    profile.reset();
+    profile.moveTo(pathLength);
+
+    startMs = lastUpdateMs = millis();
+    profileDone = false;
+    status = Status::Running;
+}
+
+void Zumo32U4Drive::measure()
+{
+    // These differences are done with unsigned numbers because signed
+    // integer overflow is undefined behavior in C++.
+    int16_t countsLeft = Zumo32U4Encoders::getCountsLeft();
+    int16_t countsRight = Zumo32U4Encoders::getCountsRight();
+    left += (int16_t)((uint16_t)countsLeft - (uint16_t)lastCountsLeft);
+    right += (int16_t)((uint16_t)countsRight - (uint16_t)lastCountsRight);
+    lastCountsLeft = countsLeft;
+    lastCountsRight = countsRight;
+
+    if (heading != NULL)
+    {
+        // Accumulate the heading in coarser units so that turns of more
+        // than 180 degrees do not wrap around, keeping the remainder in
+        // lastHeading so that no rotation is lost.
+        int32_t change = (int32_t)(*heading - lastHeading) / 256;
+        headingTotal += change;
+        lastHeading += (uint32_t)change * 256;
+    }
+}
+
+int32_t Zumo32U4Drive::measuredRotation() const
+{
+    if (heading == NULL)
+    {
+        return (right - left) / 2;
+    }
+
+    // headingTotal is 2^24 per turn.  Dropping 8 bits first keeps the
+    // product in 32 bits for turns of up to about 16 full turns, and one unit
+    // is then much less than one encoder count.
+    return headingTotal / 256 * countsPerTurn / 65536;
+}
+
+Zumo32U4Drive::Status Zumo32U4Drive::update()
+{
+    if (status != Status::Running) { return status; }
+
+    measure();
+
+    uint16_t now = millis();
+    uint16_t dt = now - lastUpdateMs;
+    if (dt == 0) { return status; }
+    lastUpdateMs = now;
+
+    if (timeoutMs != 0 && (uint16_t)(now - startMs) >= timeoutMs)
+    {
+        finish(Status::TimedOut);
+        return status;
+    }
+
+    profile.update(dt);
+
+    // Split the profile between the forward distance and the rotation.
+    int32_t position = profile.getPosition();
+    int32_t speed = profile.getSpeed();
+    int32_t wantForward = multiplyQ16(position, forwardRatio);
+    int32_t wantRotation = multiplyQ16(position, rotationRatio);
+    int32_t speedForward = multiplyQ16(speed, forwardRatio);
+    int32_t speedRotation = multiplyQ16(speed, rotationRatio);
+
+    int32_t errorForward = wantForward - (left + right) / 2;
+    int32_t errorRotation = wantRotation - measuredRotation();
+
+    int32_t leftSpeed = (speedForward - speedRotation) * feedForward / 256
+        + (errorForward - errorRotation) * proportional / 16;
+    int32_t rightSpeed = (speedForward + speedRotation) * feedForward / 256
+        + (errorForward + errorRotation) * proportional / 16;
+
+    int16_t max = Zumo32U4Motors::getMaxSpeed();
+    if (leftSpeed > max) { leftSpeed = max; }
+    if (leftSpeed < -max) { leftSpeed = -max; }
+    if (rightSpeed > max) { rightSpeed = max; }
+    if (rightSpeed < -max) { rightSpeed = -max; }
+    Zumo32U4Motors::setSpeeds(leftSpeed, rightSpeed);
+
+    if (profile.isDone())
+    {
+        if (!profileDone)
+        {
+            profileDone = true;
+            profileDoneMs = now;
+        }
+
+        bool close = labs(errorForward) <= tolerance &&
+            labs(errorRotation) <= tolerance;
+        if (close || (uint16_t)(now - profileDoneMs) >= settleMs)
+        {
+            finish(Status::Done);
+        }
+    }
+
+    return status;
+}
+
+void Zumo32U4Drive::stop()
+{
+    if (status == Status::Running)
+    {
+        finish(Status::Stopped);
+    }
+}
+
+void Zumo32U4Drive::finish(Status status)
+{
+    Zumo32U4Motors::setSpeeds(0, 0);
+    this->status = status;
+}
@@ -0,0 +1,227 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Drive.h */
+
+#pragma once
+
+#include <stdint.h>
+#include <Zumo32U4MotionProfile.h>
+
+/*! \brief Drives distances, turns, and arcs in the background using the
+ * encoders and, optionally, a gyro heading.
+ *
+ * Each command starts a movement and returns right away.  You then call
+ * update() as often as you can, for example from `loop()` or a
+ * Zumo32U4Scheduler task, and check isDone() to find out when the movement
+ * is over.  While the movement runs, your sketch is free to read sensors and
+ * decide to end it early with stop():
+ *
+ * ~~~{.cpp}
+ * Zumo32U4Drive drive;
+ *
+ * void loop()
+ * {
+ *   drive.driveDistance(300);  // 300 mm forward
+ *   while (!drive.isDone())
+ *   {
+ *     drive.update();
+ *     if (proxSensors.readBasicFront()) { drive.stop(); }
+ *   }
+ *
+ *   drive.turnAngle(90);  // 90 degrees to the left
+ *   while (!drive.isDone()) { drive.update(); }
+ * }
+ * ~~~
+ *
+ * Each movement follows a Zumo32U4MotionProfile, so the speed ramps up and
+ * down within the limits set by setSpeedLimits() instead of jumping.  The
+ * motor speeds come from a feed-forward term based on the profile speed plus
+ * a proportional correction of the position error of each wheel.
+ *
+ * The movement is tracked as two parts: the forward distance, which is the
+ * average of the left and right encoder counts, and the rotation, which is
+ * half of their difference.  Tracks slip when the robot turns, so the
+ * encoders overestimate the rotation.  If you keep a gyro heading up to date
+ * (for example with the TurnSensor.h file from the MazeSolver example), pass
+ * a pointer to it to setHeadingSource() and the rotation will be measured
+ * with the gyro instead.
+ *
+ * This class uses Zumo32U4Encoders, but does not reset their counts, and it
+ * uses `millis()` for timing. */
+class Zumo32U4Drive
+{
+public:
+
+    /*! \brief The possible states of a movement. */
+    enum class Status : uint8_t
+    {
+        /*! The movement is still in progress. */
+        Running,
+
+        /*! The movement reached its target (or was as close as it could get
+         * within the settle time). */
+        Done,
+
+        /*! The movement did not finish before the timeout. */
+        TimedOut,
+
+        /*! The movement was ended by stop(). */
+        Stopped,
+    };
+
+    Zumo32U4Drive();
+
+    /*! \brief Sets the dimensions of the robot.
+     *
+     * \param countsPerMeter The number of encoder counts per meter of travel.
+     *   The default, 7425, is for 75:1 motors: 909.7 counts per revolution
+     *   of the 39 mm sprockets.  Use 5039 for 50:1 motors and 9830 for 100:1
+     *   motors.
+     * \param trackWidthMm The distance between the centers of the tracks,
+     *   in millimeters.  The default is 85. */
+    void setGeometry(uint16_t countsPerMeter, uint16_t trackWidthMm);
+
+    /*! \brief Sets the limits for the speed of the faster track.
+     *
+     * \param speed The maximum speed, in mm/s.  The default is 300.
+     * \param acceleration The maximum acceleration, in mm/s^2.  The default
+     *   is 1000.
+     * \param jerk The maximum jerk, in mm/s^3 (up to 60000), or 0 for no
+     *   jerk limit.  The default is 0. */
+    void setSpeedLimits(uint16_t speed, uint16_t acceleration,
+        uint32_t jerk = 0);
+
+    /*! \brief Sets the gains of the controller.
+     *
+     * \param feedForward The motor speed (as passed to
+     *   Zumo32U4Motors::setSpeeds()) for each encoder count per second,
+     *   times 256.  The default is 14, which suits 75:1 motors in the
+     *   default PWM mode (see Zumo32U4Motors::setPwmMode()).
+     * \param proportional The motor speed added for each encoder count of
+     *   position error, times 16.  The default is 48. */
+    void setGains(uint16_t feedForward, uint16_t proportional);
+
+    /*! \brief Sets when a movement counts as finished.
+     *
+     * \param counts How close, in encoder counts, the forward distance and
+     *   the rotation must get to their targets.  The default is 8.
+     * \param settleMs How long to wait for the robot to get that close after
+     *   the profile has finished before ending the movement anyway.  The
+     *   default is 250. */
+    void setTolerance(uint16_t counts, uint16_t settleMs);
+
+    /*! \brief Sets the maximum time for each movement, in milliseconds.
+     *
+     * If a movement takes longer than this, for example because the robot is
+     * pushing against a wall, the motors are stopped and getStatus() returns
+     * Status::TimedOut.  The default is 0, which means there is no
+     * timeout. */
+    void setTimeout(uint16_t timeoutMs);
+
+    /*! \brief Uses a gyro heading to measure the rotation.
+     *
+     * \param heading A pointer to a heading that your sketch keeps up to
+     *   date, where 0x20000000 represents 45 degrees counter-clockwise, like
+     *   `turnAngle` in TurnSensor.h.  Pass NULL to go back to measuring the
+     *   rotation with the encoders.
+     *
+     * Your sketch must update the heading before each call to update().
+     * This should be called when no movement is running. */
+    void setHeadingSource(const uint32_t * heading);
+
+    /*! \brief Starts driving straight for the specified distance, in
+     * millimeters.
+     *
+     * Negative distances drive backward. */
+    void driveDistance(int16_t distanceMm);
+
+    /*! \brief Starts turning in place by the specified angle, in degrees.
+     *
+     * Positive angles turn counter-clockwise (to the left). */
+    void turnAngle(int16_t angleDegrees);
+
+    /*! \brief Starts driving along an arc.
+     *
+     * \param radiusMm The radius of the arc, measured to the center of the
+     *   robot, in millimeters.  The robot drives forward if this is positive
+     *   and backward if it is negative.
+     * \param angleDegrees How far to turn along the arc, in degrees.
+     *   Positive angles turn counter-clockwise (to the left). */
+    void arc(int16_t radiusMm, int16_t angleDegrees);
+
+    /*! \brief Runs the movement.
+     *
+     * This reads the encoders and the heading, advances the motion profile,
+     * and sets the motor speeds.  It should be called at least every few
+     * milliseconds while a movement is running.  When no movement is running,
+     * it does nothing.
+     *
+     * \return The status of the movement. */
+    Status update();
+
+    /*! \brief Ends the current movement and stops the motors.
+     *
+     * This does nothing if no movement is running. */
+    void stop();
+
+    /*! \brief Returns the status of the current or last movement. */
+    Status getStatus() const
+    {
+        return status;
+    }
+
+    /*! \brief Returns true if no movement is running. */
+    bool isDone() const
+    {
+        return status != Status::Running;
+    }
+
+private:
+
+    // Starts a movement, in encoder counts.
+    void start(int32_t forward, int32_t rotation);
+
+    // Reads the encoders and the heading.
+    void measure();
+
+    // Returns the rotation in encoder counts since the movement started.
+    int32_t measuredRotation() const;
+
+    void finish(Status status);
+
+    Zumo32U4MotionProfile profile;
+
+    uint16_t countsPerMeter;
+    uint16_t trackWidthMm;
+    uint16_t maxSpeed;
+    uint16_t maxAcceleration;
+    uint32_t maxJerk;
+    uint16_t feedForward;
+    uint16_t proportional;
+    uint16_t tolerance;
+    uint16_t settleMs;
+    uint16_t timeoutMs;
+
+    const uint32_t * heading;
+    uint32_t lastHeading;
+    int32_t headingTotal;  // units of 2^21 = 45 degrees
+
+    // The encoder counts since the movement started.
+    int16_t lastCountsLeft;
+    int16_t lastCountsRight;
+    int32_t left;
+    int32_t right;
+
+    int32_t targetForward;
+    int32_t targetRotation;
+    int32_t pathLength;
+    int32_t forwardRatio;   // targetForward / pathLength, times 65536
+    int32_t rotationRatio;  // targetRotation / pathLength, times 65536
+    int32_t countsPerTurn;  // for converting headingTotal to counts
+
+    uint16_t startMs;
+    uint16_t lastUpdateMs;
+    uint16_t profileDoneMs;
+    bool profileDone;
+    Status status;
+};
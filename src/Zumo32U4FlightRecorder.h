@@ -0,0 +1,380 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4FlightRecorder.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Zumo32U4IMU.h>
+
+/*! \brief Records sensor readings and motor commands in RAM so you can
+ * examine them after a run.
+ *
+ * Printing readings over the serial port while the robot is running takes
+ * time and changes the behavior you are trying to observe.  This class
+ * instead stores a snapshot of the readings you choose each time you call
+ * record(), and prints them later when you call dump(), for example after the
+ * run when a button is pressed:
+ *
+ * ~~~{.cpp}
+ * typedef Zumo32U4FlightRecorder<1024> Recorder;
+ * Recorder recorder(Recorder::Encoders | Recorder::Line | Recorder::Motors);
+ * Recorder::Snapshot snapshot;
+ *
+ * void loop()
+ * {
+ *   // ... read sensors and set motor speeds ...
+ *   snapshot.encoderLeft = encoders.getCountsLeft();
+ *   snapshot.encoderRight = encoders.getCountsRight();
+ *   recorder.record(snapshot);
+ *
+ *   if (buttonC.getSingleDebouncedPress())
+ *   {
+ *     motors.setSpeeds(0, 0);
+ *     recorder.dump(Serial);
+ *   }
+ * }
+ * ~~~
+ *
+ * The snapshots are stored in a ring buffer of fixed size, so once it is full,
+ * each new snapshot replaces the oldest ones and the buffer always holds the
+ * most recent part of the run.
+ *
+ * To fit as many snapshots as possible in the buffer, each value is stored as
+ * the difference from the same value in the previous snapshot.  Differences
+ * from -64 to 63 take one byte, differences from -8192 to 8191 take two bytes,
+ * and other differences take three bytes.  Values that change slowly, like
+ * encoder counts or line sensor readings on a uniform surface, usually take
+ * one byte each.  The compression is lossless: dump() prints exactly the
+ * values that were recorded.
+ *
+ * \tparam bufferSize The size of the ring buffer in bytes. */
+template <uint16_t bufferSize = 1024> class Zumo32U4FlightRecorder
+{
+public:
+
+    /*! Bits that select which groups of values get recorded.  The time of
+     * each snapshot is always recorded. */
+    enum Channel
+    {
+        /*! Snapshot::encoderLeft and Snapshot::encoderRight */
+        Encoders = 1 << 0,
+
+        /*! Snapshot::a */
+        Acc = 1 << 1,
+
+        /*! Snapshot::g */
+        Gyro = 1 << 2,
+
+        /*! Snapshot::line */
+        Line = 1 << 3,
+
+        /*! Snapshot::prox */
+        Proximity = 1 << 4,
+
+        /*! Snapshot::motorLeft and Snapshot::motorRight */
+        Motors = 1 << 5,
+
+        /*! All of the above. */
+        All = 0x3F,
+    };
+
+    /*! \brief The values that can be recorded by record().
+     *
+     * Only the fields selected by the channel mask passed to the constructor
+     * need to be filled in. */
+    struct Snapshot
+    {
+        /*! Encoder counts, e.g. from Zumo32U4Encoders::getCountsLeft(). */
+        int16_t encoderLeft, encoderRight;
+
+        /*! Accelerometer readings from Zumo32U4IMU::a. */
+        Zumo32U4IMU::vector<int16_t> a;
+
+        /*! Gyro readings from Zumo32U4IMU::g. */
+        Zumo32U4IMU::vector<int16_t> g;
+
+        /*! Line sensor readings.  Unused entries are ignored. */
+        uint16_t line[5];
+
+        /*! Proximity sensor counts, in the same order as the accessors of
+         * Zumo32U4ProximitySensors: left sensor with left LEDs, left sensor
+         * with right LEDs, front with left, front with right, right with left,
+         * right with right. */
+        uint8_t prox[6];
+
+        /*! Motor speeds passed to Zumo32U4Motors::setSpeeds(). */
+        int16_t motorLeft, motorRight;
+    };
+
+    /*! \brief Constructs a recorder for the specified channels.
+     *
+     * \param channels A bitwise combination of Channel values.
+     * \param lineSensorCount The number of entries of Snapshot::line to
+     *   record, from 1 to 5. */
+    Zumo32U4FlightRecorder(uint8_t channels = All, uint8_t lineSensorCount = 5)
+    {
+        this->channels = channels;
+        this->lineSensorCount = lineSensorCount > 5 ? 5 : lineSensorCount;
+
+        valueCount = 1;
+        if (channels & Encoders) { valueCount += 2; }
+        if (channels & Acc) { valueCount += 3; }
+        if (channels & Gyro) { valueCount += 3; }
+        if (channels & Line) { valueCount += this->lineSensorCount; }
+        if (channels & Proximity) { valueCount += 6; }
+        if (channels & Motors) { valueCount += 2; }
+
+        clear();
+    }
+
+    /*! \brief Discards all recorded snapshots. */
+    void clear()
+    {
+        head = tail = 0;
+        frameCount = 0;
+        for (uint8_t i = 0; i < maxValues; i++)
+        {
+            base[i] = last[i] = 0;
+        }
+    }
+
+    /*! \brief Stores a snapshot in the buffer, along with the current time
+     * from `millis()`.
+     *
+     * If there is not enough room in the buffer, the oldest snapshots are
+     * discarded to make room.
+     *
+     * \return True if the snapshot was stored, or false if the buffer is too
+     * small to hold even a single snapshot. */
+    bool record(const Snapshot & snapshot)
+    {
+        int16_t values[maxValues];
+        gather(snapshot, values);
+
+        uint8_t encoded[maxValues * 3];
+        uint8_t length = 0;
+        for (uint8_t i = 0; i < valueCount; i++)
+        {
+            length = encode(encoded, length,
+                zigzag((uint16_t)values[i] - (uint16_t)last[i]));
+        }
+
+        if (length >= bufferSize) { return false; }
+
+        while (bufferSize - 1 - getUsedBytes() < length)
+        {
+            discardOldest();
+        }
+
+        for (uint8_t i = 0; i < length; i++)
+        {
+            buffer[head] = encoded[i];
+            head = next(head);
+        }
+        for (uint8_t i = 0; i < valueCount; i++)
+        {
+            last[i] = values[i];
+        }
+        frameCount++;
+        return true;
+    }
+
+    /*! \brief Returns the number of snapshots in the buffer. */
+    uint16_t getCount() const
+    {
+        return frameCount;
+    }
+
+    /*! \brief Returns the number of bytes of the buffer in use. */
+    uint16_t getUsedBytes() const
+    {
+        return head >= tail ? head - tail : bufferSize - tail + head;
+    }
+
+    /*! \brief Prints all of the snapshots in the buffer, oldest first.
+     *
+     * The output is one header line with the names of the recorded values,
+     * followed by one line of comma-separated values per snapshot.  The first
+     * column is the time in milliseconds (the lower 16 bits of `millis()`).
+     *
+     * This function takes a long time to run, so you should stop the motors
+     * before calling it. */
+    void dump(Print & out) const
+    {
+        out.print(F("time"));
+        if (channels & Encoders) { out.print(F(",encoderLeft,encoderRight")); }
+        if (channels & Acc) { out.print(F(",ax,ay,az")); }
+        if (channels & Gyro) { out.print(F(",gx,gy,gz")); }
+        if (channels & Line)
+        {
+            for (uint8_t i = 0; i < lineSensorCount; i++)
+            {
+                out.print(F(",line"));
+                out.print(i);
+            }
+        }
+        if (channels & Proximity)
+        {
+            out.print(F(",leftLeft,leftRight,frontLeft,frontRight,rightLeft,rightRight"));
+        }
+        if (channels & Motors) { out.print(F(",motorLeft,motorRight")); }
+        out.println();
+
+        int16_t values[maxValues];
+        for (uint8_t i = 0; i < valueCount; i++) { values[i] = base[i]; }
+
+        uint16_t pos = tail;
+        for (uint16_t frame = 0; frame < frameCount; frame++)
+        {
+            pos = decodeFrame(pos, values);
+
+            out.print((uint16_t)values[0]);
+            for (uint8_t i = 1; i < valueCount; i++)
+            {
+                out.print(',');
+                out.print(values[i]);
+            }
+            out.println();
+        }
+    }
+
+private:
+
+    static const uint8_t maxValues = 22;
+
+    void gather(const Snapshot & s, int16_t * values) const
+    {
+        uint8_t n = 0;
+        values[n++] = millis();
+        if (channels & Encoders)
+        {
+            values[n++] = s.encoderLeft;
+            values[n++] = s.encoderRight;
+        }
+        if (channels & Acc)
+        {
+            values[n++] = s.a.x;
+            values[n++] = s.a.y;
+            values[n++] = s.a.z;
+        }
+        if (channels & Gyro)
+        {
+            values[n++] = s.g.x;
+            values[n++] = s.g.y;
+            values[n++] = s.g.z;
+        }
+        if (channels & Line)
+        {
+            for (uint8_t i = 0; i < lineSensorCount; i++)
+            {
+                values[n++] = s.line[i];
+            }
+        }
+        if (channels & Proximity)
+        {
+            for (uint8_t i = 0; i < 6; i++)
+            {
+                values[n++] = s.prox[i];
+            }
+        }
+        if (channels & Motors)
+        {
+            values[n++] = s.motorLeft;
+            values[n++] = s.motorRight;
+        }
+    }
+
+    // Maps signed differences to unsigned numbers so that differences with a
+    // small magnitude become small numbers: 0, -1, 1, -2, 2... become 0, 1, 2,
+    // 3, 4...
+    static uint16_t zigzag(int16_t d)
+    {
+        return ((uint16_t)d << 1) ^ (d < 0 ? 0xFFFF : 0);
+    }
+
+    static int16_t unzigzag(uint16_t z)
+    {
+        return (z >> 1) ^ (z & 1 ? 0xFFFF : 0);
+    }
+
+    static uint8_t encode(uint8_t * out, uint8_t length, uint16_t z)
+    {
+        if (z < 0x80)
+        {
+            out[length++] = z;
+        }
+        else if (z < 0x4000)
+        {
+            out[length++] = 0x80 | (z >> 8);
+            out[length++] = z & 0xFF;
+        }
+        else
+        {
+            out[length++] = 0xC0;
+            out[length++] = z & 0xFF;
+            out[length++] = z >> 8;
+        }
+        return length;
+    }
+
+    static uint16_t next(uint16_t pos)
+    {
+        pos++;
+        return pos == bufferSize ? 0 : pos;
+    }
+
+    // Decodes the snapshot starting at pos, adding its differences to values.
+    // Returns the position of the next snapshot.
+    uint16_t decodeFrame(uint16_t pos, int16_t * values) const
+    {
+        for (uint8_t i = 0; i < valueCount; i++)
+        {
+            uint8_t b0 = buffer[pos];
+            pos = next(pos);
+            uint16_t z;
+            if (b0 < 0x80)
+            {
+                z = b0;
+            }
+            else if (b0 < 0xC0)
+            {
+                z = (uint16_t)(b0 & 0x3F) << 8 | buffer[pos];
+                pos = next(pos);
+            }
+            else
+            {
+                z = buffer[pos];
+                pos = next(pos);
+                z |= (uint16_t)buffer[pos] << 8;
+                pos = next(pos);
+            }
+            values[i] = (uint16_t)values[i] + (uint16_t)unzigzag(z);
+        }
+        return pos;
+    }
+
+    // Removes the oldest snapshot.  The base values are updated to be the
+    // values of that snapshot, so the next snapshot can still be decoded.
+    void discardOldest()
+    {
+        tail = decodeFrame(tail, base);
+        frameCount--;
+    }
+
+    uint8_t buffer[bufferSize];
+    uint16_t head;
+    uint16_t tail;
+    uint16_t frameCount;
+    uint8_t channels;
+    uint8_t lineSensorCount;
+    uint8_t valueCount;
+
+    // The values of the last discarded snapshot, which the oldest snapshot in
+    // the buffer is relative to.
+    int16_t base[maxValues];
+
+    // The values of the most recently recorded snapshot.
+    int16_t last[maxValues];
+};
@@ -230,6 +230,43 @@ void Zumo32U4IMU::configureForFaceUphill()
   }
 }
 
+void Zumo32U4IMU::configureForCollisionDetection()
+{
+  switch (type)
+  {
+  case Zumo32U4IMUType::LSM303D_L3GD20H:
+
+    // Accelerometer
+
+    // 0x87 = 0b10000111
+    // AODR = 1000 (400 Hz ODR); AZEN = AYEN = AXEN = 1 (all axes enabled)
+    writeReg(LSM303D_ADDR, LSM303D_REG_CTRL1, 0x87);
+    if (lastError) { return; }
+
+    // 0x00 = 0b00000000
+    // AFS = 0 (+/- 2 g full scale)
+    writeReg(LSM303D_ADDR, LSM303D_REG_CTRL2, 0x00);
+    return;
+
+  case Zumo32U4IMUType::LSM6DS33_LIS3MDL:
+
+    // Accelerometer
+
+    // 0x60 = 0b01100000
+    // ODR = 0110 (416 Hz (high performance)); FS_XL = 00 (+/- 2 g full scale)
+    writeReg(LSM6DS33_ADDR, LSM6DS33_REG_CTRL1_XL, 0x60);
+    if (lastError) { return; }
+
+    // 0x04 = 0b00000100
+    // IF_INC = 1 (automatically increment register address)
+    writeReg(LSM6DS33_ADDR, LSM6DS33_REG_CTRL3_C, 0x04);
+    return;
+
+  default:
+    return;
+  }
+}
+
 void Zumo32U4IMU::writeReg(uint8_t addr, uint8_t reg, uint8_t value)
 {
   Wire.beginTransmission(addr);
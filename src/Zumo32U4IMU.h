@@ -123,6 +123,14 @@ public:
    * example program. */
   void configureForFaceUphill();
 
+  /*! \brief Configures the accelerometer with settings optimized for
+   * Zumo32U4CollisionDetector.
+   *
+   * This sets the accelerometer's output data rate to about 400 Hz, which is
+   * about as fast as accDataReady() and readAcc() can be called back to back
+   * with the default I2C clock of 100 kHz, and its full scale to +/- 2 g. */
+  void configureForCollisionDetection();
+
   /*! \brief Writes an 8-bit sensor register.
    *
    * \param addr Device address.
@@ -1,11 +1,16 @@
 // Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
 
 #include <Zumo32U4IRPulses.h>
+#include <Zumo32U4Timebase.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
 void Zumo32U4IRPulses::start(Direction direction, uint16_t brightness, uint16_t period)
 {
+    // If Zumo32U4Timebase is using Timer 3, save its count so it can be
+    // restored when the pulses stop.
+    Zumo32U4Timebase::suspend();
+
     // Disable Timer 3's interrupts.  This should be done first because another
     // library might be using the timer and its ISR might be modifying timer
     // registers.
@@ -98,4 +103,7 @@ void Zumo32U4IRPulses::stop()
     // can be used for measuring the battery level.
     DDRF &= ~(1 << 6);
     PORTF &= ~(1 << 6);
+
+    // Give Timer 3 back to Zumo32U4Timebase if it was using it.
+    Zumo32U4Timebase::resume();
 }
@@ -11,7 +11,8 @@
 
 Timer 3 is used to generate a PWM signal, so this library might conflict with
 other libraries that use Timer 3.  When the pulses are stopped, Timer 3 can be
-used for other purposes.
+used for other purposes.  If Zumo32U4Timebase is running, this class saves its
+count when the pulses start and restores it when they stop.
 
 Pin A1 (PF6) is used to select which set of LEDs to turn on: the left-side LEDs
 or the right-side LEDs.
@@ -0,0 +1,182 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4LineFeatures.h */
+
+#pragma once
+
+#include <stdint.h>
+
+/*! \brief Classifies what the line sensors see: line segments, branches,
+ * and dark spots.
+ *
+ * Code that navigates a grid of lines, like a maze solver, needs to answer
+ * several questions about each reading of the line sensors: is there a line at
+ * all, is there a branch to the left or right, is there a line straight ahead,
+ * and is the robot over a large dark spot?  This class answers all of them
+ * from a single pass over the calibrated readings in update():
+ *
+ * ~~~{.cpp}
+ * Zumo32U4LineFeatures features;
+ *
+ * lineSensors.readCalibrated(lineSensorValues);
+ * features.update(lineSensorValues, 5);
+ * if (features.isDarkSpot()) { ... }
+ * else if (features.hasLeft() || features.hasRight()) { ... }
+ * ~~~
+ *
+ * Each sensor whose calibrated reading is above the threshold is considered to
+ * be over a line.  getMask() returns this as a bitmask in which bit 0 is the
+ * left-most sensor.  The other functions just look at the bitmasks computed by
+ * update(), so they are fast and can be called as often as you like.
+ *
+ * Up to 8 sensors are supported.  The readings should be for a dark line on a
+ * light background, with values from 0 to 1000, like the ones returned by
+ * QTRSensors::readCalibrated(). */
+class Zumo32U4LineFeatures
+{
+public:
+
+    /*! \brief Constructor.
+     *
+     * \param threshold Sensors with readings above this value are over a
+     *   line.
+     * \param darkThreshold Sensors with readings above this value are over a
+     *   dark area, which is used by isDarkSpot(). */
+    Zumo32U4LineFeatures(uint16_t threshold = 200, uint16_t darkThreshold = 600)
+    {
+        this->threshold = threshold;
+        this->darkThreshold = darkThreshold;
+        count = 0;
+        mask = darkMask = 0;
+        segmentCount = width = 0;
+    }
+
+    /*! \brief Sets the thresholds used by update(). */
+    void setThresholds(uint16_t threshold, uint16_t darkThreshold)
+    {
+        this->threshold = threshold;
+        this->darkThreshold = darkThreshold;
+    }
+
+    /*! \brief Classifies a set of calibrated sensor readings.
+     *
+     * \param values A pointer to the readings, ordered from left to right.
+     * \param count The number of readings, from 3 to 8. */
+    void update(const uint16_t * values, uint8_t count)
+    {
+        if (count > 8) { count = 8; }
+        this->count = count;
+
+        uint8_t m = 0, dm = 0, segments = 0, run = 0, longest = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint16_t value = values[i];
+            if (value > threshold)
+            {
+                m |= 1 << i;
+                if (run == 0) { segments++; }
+                run++;
+                if (run > longest) { longest = run; }
+            }
+            else
+            {
+                run = 0;
+            }
+            if (value > darkThreshold) { dm |= 1 << i; }
+        }
+
+        mask = m;
+        darkMask = dm;
+        segmentCount = segments;
+        width = longest;
+    }
+
+    /*! \brief Returns a bitmask of the sensors that are over a line.  Bit 0 is
+     * the left-most sensor. */
+    uint8_t getMask() const
+    {
+        return mask;
+    }
+
+    /*! \brief Returns a bitmask of the sensors that are over a dark area,
+     * using the dark threshold. */
+    uint8_t getDarkMask() const
+    {
+        return darkMask;
+    }
+
+    /*! \brief Returns true if the specified sensor is over a line. */
+    bool isOnLine(uint8_t sensor) const
+    {
+        return mask >> sensor & 1;
+    }
+
+    /*! \brief Returns true if any sensor is over a line. */
+    bool lineVisible() const
+    {
+        return mask != 0;
+    }
+
+    /*! \brief Returns true if the left-most sensor is over a line, which
+     * usually means there is a branch to the left. */
+    bool hasLeft() const
+    {
+        return mask & 1;
+    }
+
+    /*! \brief Returns true if the right-most sensor is over a line, which
+     * usually means there is a branch to the right. */
+    bool hasRight() const
+    {
+        return count && (mask >> (count - 1) & 1);
+    }
+
+    /*! \brief Returns true if any of the inner sensors (all but the left-most
+     * and right-most) is over a line, which usually means there is a line
+     * straight ahead. */
+    bool hasStraight() const
+    {
+        return mask & innerMask();
+    }
+
+    /*! \brief Returns the number of separate line segments seen by the
+     * sensors.
+     *
+     * A segment is a group of adjacent sensors that are over a line, so two
+     * lines that are far enough apart give a count of 2. */
+    uint8_t getSegmentCount() const
+    {
+        return segmentCount;
+    }
+
+    /*! \brief Returns the width of the widest segment, as a number of
+     * sensors. */
+    uint8_t getWidth() const
+    {
+        return width;
+    }
+
+    /*! \brief Returns true if all of the inner sensors are over a dark area,
+     * such as the spot that marks the end of a maze. */
+    bool isDarkSpot() const
+    {
+        uint8_t inner = innerMask();
+        return inner && (darkMask & inner) == inner;
+    }
+
+private:
+
+    uint8_t innerMask() const
+    {
+        if (count < 3) { return 0; }
+        return ((1 << (count - 1)) - 1) & ~1;
+    }
+
+    uint16_t threshold;
+    uint16_t darkThreshold;
+    uint8_t count;
+    uint8_t mask;
+    uint8_t darkMask;
+    uint8_t segmentCount;
+    uint8_t width;
+};
@@ -0,0 +1,120 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4LineSensors.h>
+
+const int16_t Zumo32U4LineSensors::threeSensorPositions[3] = { 0, 2000, 4000 };
+const int16_t Zumo32U4LineSensors::fiveSensorPositions[5] =
+    { 0, 1000, 2000, 3000, 4000 };
+
+int16_t Zumo32U4LineSensors::readLinePosition(uint16_t * sensorValues,
+    uint8_t readMode, bool whiteLine, bool interpolate)
+{
+    readCalibrated(sensorValues, readMode);
+
+    // Use the same thresholds as readLine(), but find the darkest sensor in
+    // the same pass.  The values are at most 1000, so each product fits in
+    // 32 bits and the sum of the values fits in 16 bits.
+    bool onLine = false;
+    int32_t weightedSum = 0;
+    uint16_t sum = 0;
+    uint8_t peak = 0;
+    uint16_t peakValue = 0;
+    for (uint8_t i = 0; i < _numSensors; i++)
+    {
+        uint16_t value = sensorValues[i];
+        if (whiteLine) { value = 1000 - value; }
+
+        if (value > 200) { onLine = true; }
+
+        if (value > 50)
+        {
+            weightedSum += (int32_t)(int16_t)value * sensorPosition(i);
+            sum += value;
+        }
+
+        if (value > peakValue)
+        {
+            peakValue = value;
+            peak = i;
+        }
+    }
+
+    int16_t first = sensorPosition(0);
+    int16_t last = sensorPosition(_numSensors - 1);
+
+    if (!onLine)
+    {
+        // Return the position of the sensor on the side of the array where
+        // the line was last seen.
+        return lastPosition < first + (last - first) / 2 ? first : last;
+    }
+
+    if (interpolate && peak > 0 && peak < _numSensors - 1)
+    {
+        if (whiteLine)
+        {
+            // interpolatePeak() needs the values with the line being dark.
+            uint16_t values[3];
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                values[i] = 1000 - sensorValues[peak - 1 + i];
+            }
+            lastPosition = interpolatePeak(values, peak);
+        }
+        else
+        {
+            lastPosition = interpolatePeak(sensorValues + peak - 1, peak);
+        }
+    }
+    else if (sum == peakValue)
+    {
+        // Only one sensor is above the noise threshold, so the average is just
+        // its position.
+        lastPosition = sensorPosition(peak);
+    }
+    else
+    {
+        lastPosition = weightedSum / sum;
+    }
+    return lastPosition;
+}
+
+// Returns the position of the vertex of the parabola through the values of
+// sensors peak - 1, peak, and peak + 1.  values points to those three values.
+int16_t Zumo32U4LineSensors::interpolatePeak(const uint16_t * values,
+    uint8_t peak) const
+{
+    int16_t center = sensorPosition(peak);
+    int16_t a = center - sensorPosition(peak - 1);
+    int16_t b = sensorPosition(peak + 1) - center;
+
+    // Relative to the peak sensor, the neighbors are at -a and +b, and their
+    // values differ from the peak value by u and v, which are not positive.
+    // The vertex of the parabola through the three points is at:
+    //
+    //   (u * b * b - v * a * a) / (2 * (u * b + v * a))
+    //
+    // To keep the products within 32 bits, a and b are scaled down to less
+    // than 1024 and the result is scaled back up.
+    int16_t u = (int16_t)values[0] - (int16_t)values[1];
+    int16_t v = (int16_t)values[2] - (int16_t)values[1];
+    uint8_t shift = 0;
+    while (a >= 1024 || b >= 1024)
+    {
+        a >>= 1;
+        b >>= 1;
+        shift++;
+    }
+
+    int32_t denominator = 2 * ((int32_t)u * b + (int32_t)v * a);
+    if (denominator == 0) { return center; }
+    int32_t numerator = (int32_t)u * b * b - (int32_t)v * a * a;
+    int16_t offset = numerator / denominator;
+
+    // With the peak value being the largest, the vertex is within half the
+    // distance to each neighbor, but rounding could put it slightly outside.
+    if (offset < -a) { offset = -a; }
+    if (offset > b) { offset = b; }
+
+    return center + offset * (1 << shift);
+}
@@ -10,6 +10,9 @@ typedef unsigned int uint16_t;
 #pragma once
 
 #include <QTRSensors.h>
+#include <QTRSensorsStatic.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /** \brief The pin number for the standard pin that is used to read line sensor
  * 1, the left-most sensor. */
@@ -58,13 +61,13 @@ public:
      * Zumo32U4ProximitySensors object), then you will have to call
      * initThreeSensors(), initFiveSensors(), or init() before using the
      * functions in this class. */
-    Zumo32U4LineSensors() { }
+    Zumo32U4LineSensors() : positions(NULL), lastPosition(0) { }
 
     /** \brief Constructor that takes pin arguments.
      *
      * This constructor calls init() with the specified arguments. */
     Zumo32U4LineSensors(uint8_t * pins, uint8_t numSensors,
-        uint8_t emitterPin = SENSOR_LEDON)
+        uint8_t emitterPin = SENSOR_LEDON) : positions(NULL), lastPosition(0)
     {
         init(pins, numSensors, emitterPin);
     }
@@ -72,22 +75,28 @@ public:
     /** \brief Configures this object to use just three line sensors.
      *
      * This function configures this object to just use line sensors 1, 3, and
-     * 5. */
+     * 5.  It also sets the sensor positions used by readLinePosition() to
+     * #threeSensorPositions. */
     void initThreeSensors(uint8_t emitterPin = SENSOR_LEDON)
     {
         uint8_t pins[] = { SENSOR_DOWN1, SENSOR_DOWN3, SENSOR_DOWN5 };
         init(pins, sizeof(pins), 2000, emitterPin);
+        positions = threeSensorPositions;
     }
 
     /** \brief Configures this object to use all five line sensors.
      *
      * For this configuration to work, jumpers on the front sensor array must be
-     * installed in order to connect pin 20 to DN2 and connect pin 4 to DN4. */
+     * installed in order to connect pin 20 to DN2 and connect pin 4 to DN4.
+     *
+     * This function also sets the sensor positions used by readLinePosition()
+     * to #fiveSensorPositions. */
     void initFiveSensors(uint8_t emitterPin = SENSOR_LEDON)
     {
         uint8_t pins[] = { SENSOR_DOWN1, SENSOR_DOWN2, SENSOR_DOWN3,
                            SENSOR_DOWN4, SENSOR_DOWN5 };
         init(pins, sizeof(pins), 2000, emitterPin);
+        positions = fiveSensorPositions;
     }
 
     /** \brief Configures this object to use a custom set of pins.
@@ -104,6 +113,92 @@ public:
         uint16_t timeout = 2000, uint8_t emitterPin = SENSOR_LEDON)
     {
         QTRSensorsRC::init(pins, numSensors, timeout, emitterPin);
+        positions = NULL;
+    }
+
+    /** \brief The sensor positions set by initThreeSensors(): 0, 2000, and
+     * 4000.
+     *
+     * These put line sensors 1, 3, and 5 at the same positions they have
+     * in #fiveSensorPositions, so readLinePosition() returns 2000 when the
+     * line is under the middle sensor in both configurations. */
+    static const int16_t threeSensorPositions[3];
+
+    /** \brief The sensor positions set by initFiveSensors(): 0, 1000, 2000,
+     * 3000, and 4000. */
+    static const int16_t fiveSensorPositions[5];
+
+    /** \brief Sets the positions of the sensors used by readLinePosition().
+     *
+     * \param positions A pointer to an array with one position for each
+     *   sensor, in the same order as the sensor pins, in whatever units you
+     *   like (for example, tenths of a millimeter measured from the left-most
+     *   sensor).  The positions must be in increasing order and no more than
+     *   32767 apart in total.  The array is not copied, so it must remain
+     *   valid while this object is in use.  A null pointer makes sensor \a i
+     *   have a position of 1000 * \a i, which is the same as readLine().
+     *
+     * This is useful if you use a set of sensors that is not evenly spaced,
+     * such as sensors 1, 2, 3, and 5. */
+    void setSensorPositions(const int16_t * positions)
+    {
+        this->positions = positions;
     }
+
+    /** \brief Reads the sensors, provides calibrated values, and returns an
+     * estimated line position using the sensor positions.
+     *
+     * This works like QTRSensors::readLine(), but the weighted average uses
+     * the positions set by setSensorPositions(), initThreeSensors(), or
+     * initFiveSensors() instead of assuming the sensors are 1000 units apart.
+     * With positions of 0, 1000, 2000, etc., it returns the same result as
+     * readLine().
+     *
+     * If \p interpolate is true, the position is instead found by fitting a
+     * parabola through the reading of the darkest sensor and its two
+     * neighbors and returning the position of the parabola's peak.  This
+     * only uses the sensors closest to the line, so it is less affected by
+     * other sensors that see part of the line or another nearby line, and it
+     * usually changes more smoothly as the line moves between two sensors.  If
+     * the darkest sensor is at either end of the array, the weighted average is
+     * used instead.
+     *
+     * When no sensor sees the line, this function returns the position of the
+     * left-most or right-most sensor, depending on which side of the center
+     * the line was last seen.
+     *
+     * \param[out] sensorValues A pointer to an array in which to store the
+     *   calibrated sensor readings.
+     * \param readMode The emitter behavior during the read (see \ref
+     *   read_modes).
+     * \param whiteLine True if the line is lighter than its background.
+     * \param interpolate True to use parabolic interpolation around the
+     *   darkest sensor instead of the weighted average of all sensors. */
+    int16_t readLinePosition(uint16_t * sensorValues,
+        uint8_t readMode = QTR_EMITTERS_ON, bool whiteLine = false,
+        bool interpolate = false);
+
+private:
+
+    const int16_t * positions;
+    int16_t lastPosition;
+
+    int16_t sensorPosition(uint8_t i) const
+    {
+        return positions ? positions[i] : (int16_t)(i * 1000);
+    }
+
+    int16_t interpolatePeak(const uint16_t * values, uint8_t peak) const;
 };
 
+/** \brief Reads line sensors 1, 3, and 5 like
+ * Zumo32U4LineSensors::initThreeSensors(), but without dynamic memory or
+ * virtual functions (see QTRSensorsStatic). */
+typedef QTRSensorsStatic<SENSOR_LEDON, SENSOR_DOWN1, SENSOR_DOWN3,
+    SENSOR_DOWN5> Zumo32U4LineSensorsStatic3;
+
+/** \brief Reads all five line sensors like
+ * Zumo32U4LineSensors::initFiveSensors(), but without dynamic memory or
+ * virtual functions (see QTRSensorsStatic). */
+typedef QTRSensorsStatic<SENSOR_LEDON, SENSOR_DOWN1, SENSOR_DOWN2,
+    SENSOR_DOWN3, SENSOR_DOWN4, SENSOR_DOWN5> Zumo32U4LineSensorsStatic5;
@@ -0,0 +1,267 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4LoopProfiler.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Zumo32U4Timebase.h>
+
+/*! \brief Measures how long sections of a control loop take and how steady
+ * the loop rate is.
+ *
+ * Each section of code you want to measure is identified by a small number
+ * returned by addSection().  You can measure the duration of a section by
+ * calling start() before it and stop() after it, or you can measure the time
+ * between consecutive passes through a point in your loop by calling lap()
+ * there.  Calling lap() at the top of `loop()` measures the loop period, which
+ * shows whether your loop is running at the rate you expect.
+ *
+ * For each section, this class keeps the number of samples, the minimum,
+ * maximum, and mean duration in microseconds, and a histogram with
+ * #histogramBins bins.  The bins are spaced logarithmically: bin 0 counts
+ * durations below 64 us, bin 1 counts durations from 64 us to 127 us, bin 2
+ * counts 128 us to 255 us, and so on, with the last bin counting everything
+ * longer than that.  All of the data is stored in fixed arrays inside the
+ * object, so it does not use any dynamic memory.
+ *
+ * By default, durations are measured with `micros()`, which has a resolution
+ * of 4 microseconds and takes several microseconds to run.  If you set the
+ * \p useTimebase template parameter to true, durations are measured with
+ * Zumo32U4Timebase instead, which has a resolution of 0.5 microseconds and
+ * takes much less time to read, but uses Timer 3 (see Zumo32U4Timebase for
+ * details).
+ *
+ * Durations are measured with 16-bit timestamps, so the longest duration that
+ * can be measured is 65535 microseconds, or 32767 microseconds when using
+ * Zumo32U4Timebase.
+ *
+ * \tparam sectionCount The maximum number of sections.  Each section uses
+ * 31 bytes of RAM.
+ * \tparam useTimebase True to measure durations with Zumo32U4Timebase, or
+ * false to use `micros()`. */
+template <uint8_t sectionCount = 4, bool useTimebase = false>
+class Zumo32U4LoopProfiler
+{
+public:
+
+    /*! The number of bins in the histogram for each section. */
+    static const uint8_t histogramBins = 8;
+
+    /*! The upper limit, in microseconds, of the duration counted by bin 0 of
+     * the histogram.  Each of the following bins is twice as wide as the bin
+     * before it. */
+    static const uint16_t firstBinLimitUs = 64;
+
+    Zumo32U4LoopProfiler()
+    {
+        numSections = 0;
+    }
+
+    /*! \brief Adds a new section and returns its number.
+     *
+     * \param name The name of the section, which is used by print().  You can
+     * use the F() macro to store it in flash, for example
+     * `addSection(F("imu"))`.
+     *
+     * \return The number of the new section, which you should pass to the other
+     * functions in this class.  If there is no room for more sections, this
+     * function returns 255, and the other functions will ignore that
+     * number.
+     *
+     * If \p useTimebase is true, this function also calls
+     * Zumo32U4Timebase::init(), so you should call it from `setup()`. */
+    uint8_t addSection(const __FlashStringHelper * name)
+    {
+        if (useTimebase) { Zumo32U4Timebase::init(); }
+        if (numSections >= sectionCount) { return 255; }
+        sections[numSections].name = name;
+        resetSection(numSections);
+        return numSections++;
+    }
+
+    /*! \brief Records the time at the start of a section.
+     *
+     * Call stop() with the same section number at the end of the section. */
+    void start(uint8_t section)
+    {
+        if (section >= numSections) { return; }
+        sections[section].lastTime = now();
+    }
+
+    /*! \brief Records the time at the end of a section and adds the time since
+     * the matching call to start() to the statistics for the section. */
+    void stop(uint8_t section)
+    {
+        if (section >= numSections) { return; }
+        addSample(section, elapsedUs(sections[section].lastTime));
+    }
+
+    /*! \brief Adds the time since the previous call to lap() with the same
+     * section number to the statistics for the section.
+     *
+     * The first call to lap() after the section is added or reset only
+     * records the time. */
+    void lap(uint8_t section)
+    {
+        if (section >= numSections) { return; }
+        uint16_t time = now();
+        if (sections[section].lapStarted)
+        {
+            addSample(section, toUs(time - sections[section].lastTime));
+        }
+        sections[section].lastTime = time;
+        sections[section].lapStarted = true;
+    }
+
+    /*! \brief Clears the statistics for all sections. */
+    void reset()
+    {
+        for (uint8_t i = 0; i < numSections; i++)
+        {
+            resetSection(i);
+        }
+    }
+
+    /*! \brief Returns the number of samples recorded for the section. */
+    uint16_t getCount(uint8_t section) const
+    {
+        if (section >= numSections) { return 0; }
+        return sections[section].count;
+    }
+
+    /*! \brief Returns the shortest duration recorded for the section, in
+     * microseconds, or 0 if there are no samples. */
+    uint16_t getMin(uint8_t section) const
+    {
+        if (section >= numSections || sections[section].count == 0) { return 0; }
+        return sections[section].min;
+    }
+
+    /*! \brief Returns the longest duration recorded for the section, in
+     * microseconds. */
+    uint16_t getMax(uint8_t section) const
+    {
+        if (section >= numSections) { return 0; }
+        return sections[section].max;
+    }
+
+    /*! \brief Returns the mean duration recorded for the section, in
+     * microseconds, or 0 if there are no samples. */
+    uint16_t getMean(uint8_t section) const
+    {
+        if (section >= numSections || sections[section].count == 0) { return 0; }
+        return sections[section].total / sections[section].count;
+    }
+
+    /*! \brief Returns the number of samples in the specified histogram bin of
+     * the section.
+     *
+     * \param section The section number.
+     * \param bin A number between 0 and #histogramBins - 1. */
+    uint16_t getHistogram(uint8_t section, uint8_t bin) const
+    {
+        if (section >= numSections || bin >= histogramBins) { return 0; }
+        return sections[section].histogram[bin];
+    }
+
+    /*! \brief Prints the statistics for all sections.
+     *
+     * One line of comma-separated values is printed for each section, in this
+     * format:
+     *
+     *     name,count,min,mean,max,bin0,bin1,...
+     *
+     * You can pass `Serial` or a display object to this function. */
+    void print(Print & out) const
+    {
+        for (uint8_t i = 0; i < numSections; i++)
+        {
+            out.print(sections[i].name);
+            out.print(',');
+            out.print(getCount(i));
+            out.print(',');
+            out.print(getMin(i));
+            out.print(',');
+            out.print(getMean(i));
+            out.print(',');
+            out.print(getMax(i));
+            for (uint8_t bin = 0; bin < histogramBins; bin++)
+            {
+                out.print(',');
+                out.print(sections[i].histogram[bin]);
+            }
+            out.println();
+        }
+    }
+
+private:
+
+    struct Section
+    {
+        const __FlashStringHelper * name;
+        uint16_t lastTime;
+        bool lapStarted;
+        uint16_t count;
+        uint16_t min;
+        uint16_t max;
+        uint32_t total;
+        uint16_t histogram[histogramBins];
+    };
+
+    static uint16_t now()
+    {
+        return useTimebase ? Zumo32U4Timebase::ticks() : (uint16_t)micros();
+    }
+
+    static uint16_t toUs(uint16_t elapsed)
+    {
+        return useTimebase ? Zumo32U4Timebase::ticksToUs(elapsed) : elapsed;
+    }
+
+    static uint16_t elapsedUs(uint16_t since)
+    {
+        return toUs(now() - since);
+    }
+
+    void resetSection(uint8_t section)
+    {
+        Section & s = sections[section];
+        s.lapStarted = false;
+        s.count = 0;
+        s.min = 0xFFFF;
+        s.max = 0;
+        s.total = 0;
+        for (uint8_t bin = 0; bin < histogramBins; bin++)
+        {
+            s.histogram[bin] = 0;
+        }
+    }
+
+    void addSample(uint8_t section, uint16_t duration)
+    {
+        Section & s = sections[section];
+
+        // Stop recording instead of letting the count overflow, so the mean
+        // stays correct.
+        if (s.count == 0xFFFF) { return; }
+
+        s.count++;
+        s.total += duration;
+        if (duration < s.min) { s.min = duration; }
+        if (duration > s.max) { s.max = duration; }
+
+        uint8_t bin = 0;
+        uint16_t limit = firstBinLimitUs;
+        while (bin < histogramBins - 1 && duration >= limit)
+        {
+            bin++;
+            limit <<= 1;
+        }
+        s.histogram[bin]++;
+    }
+
+    Section sections[sectionCount];
+    uint8_t numSections;
+};
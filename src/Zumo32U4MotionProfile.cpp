@@ -0,0 +1,172 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4MotionProfile.h>
+#include <Zumo32U4Trig.h>
+#include <stdlib.h>
+
+Zumo32U4MotionProfile::Zumo32U4MotionProfile()
+{
+    setLimits(400, 1600);
+    reset();
+}
+
+void Zumo32U4MotionProfile::setLimits(uint16_t maxSpeed,
+    uint16_t maxAcceleration, uint32_t maxJerk)
+{
+    // These limits keep the intermediate results of update() within 32
+    // bits.
+    if (maxSpeed > 30000) { maxSpeed = 30000; }
+    if (maxAcceleration > 32767) { maxAcceleration = 32767; }
+    if (maxAcceleration == 0) { maxAcceleration = 1; }
+    if (maxJerk > 10000000) { maxJerk = 10000000; }
+
+    this->maxSpeed = maxSpeed;
+    this->maxAcceleration = maxAcceleration;
+    this->maxJerk = maxJerk;
+}
+
+void Zumo32U4MotionProfile::setSpeedTarget(int16_t speed)
+{
+    if (speed > (int16_t)maxSpeed) { speed = maxSpeed; }
+    if (speed < -(int16_t)maxSpeed) { speed = -maxSpeed; }
+    positionMode = false;
+    targetSpeed = (int32_t)speed * 256;
+    done = this->speed == targetSpeed;
+}
+
+void Zumo32U4MotionProfile::moveTo(int32_t position)
+{
+    positionMode = true;
+    targetPosition = position * 256;
+    done = false;
+}
+
+void Zumo32U4MotionProfile::moveBy(int32_t distance)
+{
+    int32_t start = positionMode ? targetPosition : position;
+    moveTo((start >> 8) + distance);
+}
+
+void Zumo32U4MotionProfile::reset(int32_t position)
+{
+    this->position = position * 256;
+    positionRemainder = 0;
+    speed = 0;
+    acceleration = 0;
+    positionMode = false;
+    targetSpeed = 0;
+    targetPosition = this->position;
+    done = true;
+}
+
+void Zumo32U4MotionProfile::update(uint16_t dtMs)
+{
+    if (dtMs == 0) { return; }
+    if (dtMs > 200) { dtMs = 200; }
+
+    int32_t target = targetSpeed;
+
+    if (positionMode)
+    {
+        int32_t error = targetPosition - position;
+
+        // Plan the stop with a lower deceleration than the limit so that the
+        // discrete steps do not overshoot the target.  With a jerk limit,
+        // the speed cannot drop as quickly, so the margin is larger.
+        uint32_t a = maxAcceleration;
+        if (maxJerk) { a = a / 2 + 1; }
+        else { a = a - a / 8; }
+
+        // Stop when within one unit of the target if the speed can be
+        // brought to zero in one step.
+        int32_t step = (uint32_t)a * dtMs * 32 / 125;
+        if (labs(error) < 256 && labs(speed) <= step)
+        {
+            position = targetPosition;
+            positionRemainder = 0;
+            speed = 0;
+            acceleration = 0;
+            done = true;
+            return;
+        }
+
+        // The highest speed from which we can still stop at the target is
+        // sqrt(2 * a * distance).
+        uint32_t distance = labs(error) >> 8;
+        uint32_t v = maxSpeed;
+        if (distance < (uint32_t)maxSpeed * maxSpeed / (2 * a))
+        {
+            v = Zumo32U4Trig::squareRoot(2 * a * distance);
+        }
+        target = (int32_t)v * 256;
+        if (error < 0) { target = -target; }
+    }
+
+    stepSpeed(target, dtMs);
+
+    // Integrate the speed, keeping track of the fractions that are lost in
+    // the division.
+    int32_t p = speed * dtMs + positionRemainder;
+    position += p / 1000;
+    positionRemainder = p % 1000;
+
+    if (!positionMode)
+    {
+        done = speed == targetSpeed;
+    }
+}
+
+void Zumo32U4MotionProfile::stepSpeed(int32_t target, uint16_t dtMs)
+{
+    int32_t error = target - speed;
+
+    if (maxJerk == 0)
+    {
+        // Trapezoidal profile: change the speed by at most the maximum
+        // acceleration times the time step.
+        int32_t maxChange = (uint32_t)maxAcceleration * dtMs * 32 / 125;
+        if (error > maxChange) { error = maxChange; }
+        if (error < -maxChange) { error = -maxChange; }
+        speed += error;
+        acceleration = error * 1000 / dtMs;
+        return;
+    }
+
+    // S-curve profile: choose the acceleration we want, then change the
+    // acceleration toward it by at most the maximum jerk times the time step.
+    int32_t maxAccel = (int32_t)maxAcceleration * 256;
+    int32_t wantedAccel = 0;
+    if (error != 0)
+    {
+        wantedAccel = error > 0 ? maxAccel : -maxAccel;
+
+        // Reducing the acceleration a to zero at jerk j changes the speed by
+        // a^2 / (2 j), so start reducing it when the speed is that close to
+        // the target.
+        if ((error > 0) == (acceleration > 0) && acceleration != 0)
+        {
+            uint32_t a = labs(acceleration) >> 8;
+            uint32_t stoppingChange = a * a / (2 * maxJerk);
+            if ((uint32_t)(labs(error) >> 8) <= stoppingChange)
+            {
+                wantedAccel = 0;
+            }
+        }
+    }
+
+    int32_t maxAccelChange = maxJerk * dtMs / 125 * 32;
+    int32_t accelError = wantedAccel - acceleration;
+    if (accelError > maxAccelChange) { accelError = maxAccelChange; }
+    if (accelError < -maxAccelChange) { accelError = -maxAccelChange; }
+    acceleration += accelError;
+
+    speed += acceleration * dtMs / 1000;
+
+    // Don't go past the target; the acceleration is small by then.
+    if (error == 0 || (error > 0 && speed >= target) ||
+        (error < 0 && speed <= target))
+    {
+        speed = target;
+        acceleration = 0;
+    }
+}
@@ -0,0 +1,136 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4MotionProfile.h */
+
+#pragma once
+
+#include <stdint.h>
+
+/*! \brief Generates smooth, acceleration-limited speed and position
+ * profiles.
+ *
+ * Changing the motor speeds instantly, for example from 0 to 400, makes the
+ * wheels slip and the robot jerk, which wastes traction and makes the encoder
+ * counts less accurate.  This class ramps a speed from its current value to a
+ * target value without exceeding a maximum acceleration, and optionally a
+ * maximum jerk (rate of change of acceleration).  With only an acceleration
+ * limit, the speed follows a trapezoidal profile; with a jerk limit, the
+ * corners of the trapezoid are rounded into an S-curve.
+ *
+ * You call update() at a regular rate, for example every 10 ms from a
+ * Zumo32U4Scheduler task, with the time since the last call, and then use
+ * getSpeed() as the motor speed:
+ *
+ * ~~~{.cpp}
+ * Zumo32U4MotionProfile profile;
+ *
+ * void setup()
+ * {
+ *   // Up to speed 400, taking at least 0.25 s to get there.
+ *   profile.setLimits(400, 1600);
+ *   profile.setSpeedTarget(400);
+ * }
+ *
+ * void controlTask()  // every 10 ms
+ * {
+ *   profile.update(10);
+ *   motors.setSpeeds(profile.getSpeed(), profile.getSpeed());
+ * }
+ * ~~~
+ *
+ * The profile can also move a position to a target with moveTo() or
+ * moveBy().  The speed rises to the maximum and then falls so that the
+ * position reaches the target with zero speed.  The units of position are up
+ * to you: if the speed is in encoder counts per second, for example, then the
+ * position is in encoder counts.
+ *
+ * All of the calculations use integers, with 8 fractional bits for the speed,
+ * acceleration, and position. */
+class Zumo32U4MotionProfile
+{
+public:
+
+    Zumo32U4MotionProfile();
+
+    /*! \brief Sets the limits of the profile.
+     *
+     * \param maxSpeed The maximum speed, in units per second (up to 30000).
+     * \param maxAcceleration The maximum acceleration, in units per second
+     *   per second (up to 32767).
+     * \param maxJerk The maximum jerk, in units per second cubed, or 0 for no
+     *   jerk limit (a trapezoidal profile). */
+    void setLimits(uint16_t maxSpeed, uint16_t maxAcceleration,
+        uint32_t maxJerk = 0);
+
+    /*! \brief Makes the speed ramp to the specified value and stay there.
+     *
+     * The speed is limited to the maximum speed. */
+    void setSpeedTarget(int16_t speed);
+
+    /*! \brief Makes the position move to the specified value and stop. */
+    void moveTo(int32_t position);
+
+    /*! \brief Makes the position move by the specified distance from the
+     * current target position and stop. */
+    void moveBy(int32_t distance);
+
+    /*! \brief Stops the profile instantly and sets its position.
+     *
+     * The speed and acceleration become 0 and the speed target becomes 0. */
+    void reset(int32_t position = 0);
+
+    /*! \brief Advances the profile.
+     *
+     * \param dtMs The time since the last call, in milliseconds.  Times over
+     *   200 ms are treated as 200 ms. */
+    void update(uint16_t dtMs);
+
+    /*! \brief Returns the current speed, in units per second. */
+    int16_t getSpeed() const
+    {
+        return speed >> 8;
+    }
+
+    /*! \brief Returns the current acceleration, in units per second per
+     * second. */
+    int16_t getAcceleration() const
+    {
+        return acceleration >> 8;
+    }
+
+    /*! \brief Returns the current position. */
+    int32_t getPosition() const
+    {
+        return position >> 8;
+    }
+
+    /*! \brief Returns true if the speed has reached its target, or in position
+     * mode, if the position has reached its target and stopped. */
+    bool isDone() const
+    {
+        return done;
+    }
+
+private:
+
+    // Moves the speed toward the target with the acceleration and jerk
+    // limits.
+    void stepSpeed(int32_t target, uint16_t dtMs);
+
+    uint16_t maxSpeed;
+    uint16_t maxAcceleration;
+    uint32_t maxJerk;
+
+    bool positionMode;
+    bool done;
+    int32_t targetSpeed;     // units/s << 8
+    int32_t targetPosition;  // units << 8
+
+    int32_t speed;           // units/s << 8
+    int32_t acceleration;    // units/s/s << 8
+    int32_t position;        // units << 8
+
+    // The part of (speed * ms) that has not yet been added to position
+    // because it is less than 1/256 unit.
+    int32_t positionRemainder;
+};
@@ -12,6 +12,13 @@
 static bool flipLeft = false;
 static bool flipRight = false;
 
+// The value of ICR1, which is the speed for a 100% duty cycle.
+static uint16_t maxSpeed = 400;
+
+// The last speeds that were set, after limiting.
+static int16_t leftSpeed = 0;
+static int16_t rightSpeed = 0;
+
 // initialize timer1 to generate the proper PWM outputs to the motor drivers
 void Zumo32U4Motors::init2()
 {
@@ -35,6 +42,50 @@ void Zumo32U4Motors::init2()
     OCR1B = 0;
 }
 
+void Zumo32U4Motors::setPwmMode(PwmMode mode)
+{
+    init();
+
+    // Each mode is phase-correct PWM with ICR1 as the top, so the PWM
+    // frequency is 16MHz / prescaler / 2 / top.
+    uint8_t clockSelect;
+    switch (mode)
+    {
+    case PwmMode::TenBit:
+        // 16MHz / 1 / 2 / 1023 = 7.8kHz
+        clockSelect = 0b001;
+        maxSpeed = 1023;
+        break;
+
+    case PwmMode::LowFrequency:
+        // 16MHz / 8 / 2 / 1000 = 1kHz
+        clockSelect = 0b010;
+        maxSpeed = 1000;
+        break;
+
+    default:
+        // 16MHz / 1 / 2 / 400 = 20kHz
+        clockSelect = 0b001;
+        maxSpeed = 400;
+        break;
+    }
+
+    // Stop the timer while changing the top so that the counter cannot end
+    // up above the new top.
+    TCCR1B = 0b00010000;
+    OCR1A = 0;
+    OCR1B = 0;
+    leftSpeed = rightSpeed = 0;
+    TCNT1 = 0;
+    ICR1 = maxSpeed;
+    TCCR1B = 0b00010000 | clockSelect;
+}
+
+uint16_t Zumo32U4Motors::getMaxSpeed()
+{
+    return maxSpeed;
+}
+
 // enable/disable flipping of left motor
 void Zumo32U4Motors::flipLeftMotor(bool flip)
 {
@@ -47,7 +98,7 @@ void Zumo32U4Motors::flipRightMotor(bool flip)
     flipRight = flip;
 }
 
-// set speed for left motor; speed is a number between -400 and 400
+// set speed for left motor; speed is a number between -maxSpeed and maxSpeed
 void Zumo32U4Motors::setLeftSpeed(int16_t speed)
 {
     init();
@@ -59,17 +110,18 @@ void Zumo32U4Motors::setLeftSpeed(int16_t speed)
         speed = -speed; // Make speed a positive quantity.
         reverse = 1;    // Preserve the direction.
     }
-    if (speed > 400)    // Max PWM duty cycle.
+    if ((uint16_t)speed > maxSpeed)  // Max PWM duty cycle.
     {
-        speed = 400;
+        speed = maxSpeed;
     }
 
     OCR1B = speed;
+    leftSpeed = reverse ? -speed : speed;
 
     FastGPIO::Pin<DIR_L>::setOutput(reverse ^ flipLeft);
 }
 
-// set speed for right motor; speed is a number between -400 and 400
+// set speed for right motor; speed is a number between -maxSpeed and maxSpeed
 void Zumo32U4Motors::setRightSpeed(int16_t speed)
 {
     init();
@@ -81,12 +133,13 @@ void Zumo32U4Motors::setRightSpeed(int16_t speed)
         speed = -speed;  // Make speed a positive quantity.
         reverse = 1;     // Preserve the direction.
     }
-    if (speed > 400)     // Max PWM duty cycle.
+    if ((uint16_t)speed > maxSpeed)  // Max PWM duty cycle.
     {
-        speed = 400;
+        speed = maxSpeed;
     }
 
     OCR1A = speed;
+    rightSpeed = reverse ? -speed : speed;
 
     FastGPIO::Pin<DIR_R>::setOutput(reverse ^ flipRight);
 }
@@ -97,3 +150,13 @@ void Zumo32U4Motors::setSpeeds(int16_t leftSpeed, int16_t rightSpeed)
   setLeftSpeed(leftSpeed);
   setRightSpeed(rightSpeed);
 }
+
+int16_t Zumo32U4Motors::getLeftSpeed()
+{
+    return leftSpeed;
+}
+
+int16_t Zumo32U4Motors::getRightSpeed()
+{
+    return rightSpeed;
+}
@@ -9,11 +9,50 @@
 /*! \brief Controls motor speed and direction on the Zumo 32U4.
  *
  * This library uses Timer 1, so it will conflict with any other libraries using
- * that timer. */
+ * that timer.
+ *
+ * By default, the PWM frequency is 20 kHz, which is too high to hear, and
+ * speeds range from -400 to 400.  setPwmMode() can select a mode with more
+ * steps, which gives finer control at low speeds, or a lower frequency.
+ *
+ * A speed of 0 brakes the motor: the DRV8838 motor drivers connect both motor
+ * terminals to ground while their enable inputs are low.  To stop even faster,
+ * see Zumo32U4Brake. */
 class Zumo32U4Motors
 {
   public:
 
+    /** \brief The PWM configurations that setPwmMode() can select.
+     *
+     * All of the modes use phase-correct PWM on Timer 1. */
+    enum class PwmMode : uint8_t
+    {
+        /** 20 kHz with speeds from -400 to 400.  This is the default. */
+        Ultrasonic,
+
+        /** 7.8 kHz with speeds from -1023 to 1023 (10-bit resolution).  The
+         * motors make an audible whine in this mode. */
+        TenBit,
+
+        /** 1 kHz with speeds from -1000 to 1000.  At low speeds, the longer
+         * pulses let the motor current build up further, which can help the
+         * motors start turning, but the motors are noisier. */
+        LowFrequency,
+    };
+
+    /** \brief Selects the PWM frequency and resolution.
+     *
+     * This stops both motors.  After calling this, the speeds passed to
+     * setLeftSpeed(), setRightSpeed(), and setSpeeds() range from
+     * -getMaxSpeed() to getMaxSpeed(), so code written for the default range
+     * of -400 to 400 should scale its speeds.  The motor flip settings are
+     * not changed. */
+    static void setPwmMode(PwmMode mode);
+
+    /** \brief Returns the speed that corresponds to a 100% duty cycle in the
+     * current PWM mode: 400 by default. */
+    static uint16_t getMaxSpeed();
+
     /** \brief Flips the direction of the left motor.
      *
      * You can call this function with an argument of \c true if the left motor
@@ -41,14 +80,18 @@ class Zumo32U4Motors
      *
      * \param speed A number from -400 to 400 representing the speed and
      * direction of the left motor.  Values of -400 or less result in full speed
-     * reverse, and values of 400 or more result in full speed forward. */
+     * reverse, and values of 400 or more result in full speed forward.  If
+     * setPwmMode() has been called, the range is -getMaxSpeed() to
+     * getMaxSpeed() instead. */
     static void setLeftSpeed(int16_t speed);
 
     /** \brief Sets the speed for the right motor.
      *
      * \param speed A number from -400 to 400 representing the speed and
      * direction of the right motor. Values of -400 or less result in full speed
-     * reverse, and values of 400 or more result in full speed forward. */
+     * reverse, and values of 400 or more result in full speed forward.  If
+     * setPwmMode() has been called, the range is -getMaxSpeed() to
+     * getMaxSpeed() instead. */
     static void setRightSpeed(int16_t speed);
 
     /** \brief Sets the speeds for both motors.
@@ -58,9 +101,23 @@ class Zumo32U4Motors
      * reverse, and values of 400 or more result in full speed forward.
      * \param rightSpeed A number from -400 to 400 representing the speed and
      * direction of the right motor. Values of -400 or less result in full speed
-     * reverse, and values of 400 or more result in full speed forward. */
+     * reverse, and values of 400 or more result in full speed forward.
+     *
+     * If setPwmMode() has been called, the range is -getMaxSpeed() to
+     * getMaxSpeed() instead of -400 to 400. */
     static void setSpeeds(int16_t leftSpeed, int16_t rightSpeed);
 
+    /** \brief Returns the speed that was last set for the left motor.
+     *
+     * This is the speed after it was limited to the allowed range, so it is
+     * the speed the motor is actually being driven at. */
+    static int16_t getLeftSpeed();
+
+    /** \brief Returns the speed that was last set for the right motor.
+     *
+     * See getLeftSpeed(). */
+    static int16_t getRightSpeed();
+
   private:
 
     static inline void init()
@@ -0,0 +1,94 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Odometry.h>
+#include <Zumo32U4Encoders.h>
+#include <Zumo32U4Trig.h>
+
+Zumo32U4Odometry::Zumo32U4Odometry()
+{
+    setGeometry(7425, 85);
+    x = y = 0;
+    heading = 0;
+    gyroStarted = false;
+    countsStarted = false;
+}
+
+void Zumo32U4Odometry::setGeometry(uint16_t countsPerMeter,
+    uint16_t trackWidthMm)
+{
+    if (countsPerMeter < 1000) { countsPerMeter = 1000; }
+    if (trackWidthMm == 0) { trackWidthMm = 1; }
+
+    mmPerCount = 65536000 / countsPerMeter;
+
+    // A difference of one count between the tracks turns the robot by
+    // 1 / (the track width in counts) radians, and one radian is
+    // 2^32 / (2 pi) = 683565275.576 heading units.
+    anglePerCount = 683565275576ULL /
+        ((uint32_t)trackWidthMm * countsPerMeter);
+}
+
+void Zumo32U4Odometry::reset(int32_t xMm, int32_t yMm, uint32_t heading)
+{
+    x = xMm * 256;
+    y = yMm * 256;
+    this->heading = heading;
+    gyroStarted = false;
+
+    lastCountsLeft = Zumo32U4Encoders::getCountsLeft();
+    lastCountsRight = Zumo32U4Encoders::getCountsRight();
+    countsStarted = true;
+}
+
+void Zumo32U4Odometry::update()
+{
+    int16_t countsLeft = Zumo32U4Encoders::getCountsLeft();
+    int16_t countsRight = Zumo32U4Encoders::getCountsRight();
+
+    if (countsStarted)
+    {
+        // These differences are done with unsigned numbers because signed
+        // integer overflow is undefined behavior in C++.
+        update((int16_t)((uint16_t)countsLeft - (uint16_t)lastCountsLeft),
+            (int16_t)((uint16_t)countsRight - (uint16_t)lastCountsRight));
+    }
+
+    lastCountsLeft = countsLeft;
+    lastCountsRight = countsRight;
+    countsStarted = true;
+}
+
+void Zumo32U4Odometry::update(int16_t deltaLeft, int16_t deltaRight)
+{
+    int32_t difference = (int32_t)deltaRight - deltaLeft;
+    move(deltaLeft, deltaRight, heading + (uint32_t)difference * anglePerCount);
+}
+
+void Zumo32U4Odometry::update(int16_t deltaLeft, int16_t deltaRight,
+    uint32_t gyroHeading)
+{
+    if (!gyroStarted)
+    {
+        gyroOffset = heading - gyroHeading;
+        gyroStarted = true;
+    }
+    move(deltaLeft, deltaRight, gyroHeading + gyroOffset);
+}
+
+void Zumo32U4Odometry::move(int16_t deltaLeft, int16_t deltaRight,
+    uint32_t newHeading)
+{
+    // The distance traveled by the center of the robot, in mm << 8.
+    int32_t distance = ((int32_t)deltaLeft + deltaRight) * mmPerCount;
+    distance = (distance + 256) >> 9;
+
+    // Assume the robot moved along a straight line in the direction halfway
+    // between the old and new headings, which is a good approximation of
+    // the arc it actually drove when the heading changes only a little.
+    uint32_t middle = heading + (int32_t)(newHeading - heading) / 2;
+    uint16_t angle = (middle + 0x8000) >> 16;
+
+    x += (distance * Zumo32U4Trig::cosine(angle) + 8192) >> 14;
+    y += (distance * Zumo32U4Trig::sine(angle) + 8192) >> 14;
+    heading = newHeading;
+}
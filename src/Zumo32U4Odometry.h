@@ -0,0 +1,142 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Odometry.h */
+
+#pragma once
+
+#include <stdint.h>
+
+/*! \brief Keeps track of the position and heading of the robot from the
+ * encoders and, optionally, a gyro.
+ *
+ * This class estimates the pose of the robot: its position (x, y) in
+ * millimeters and its heading, relative to where it was when reset() was
+ * called.  At the start, the robot is facing along the positive x axis, and
+ * the positive y axis is to its left.
+ *
+ * You call update() at a regular rate, for example every 10 ms from a
+ * Zumo32U4Scheduler task:
+ *
+ * ~~~{.cpp}
+ * Zumo32U4Odometry odometry;
+ *
+ * void setup()
+ * {
+ *   odometry.reset();
+ * }
+ *
+ * void odometryTask()  // every 10 ms
+ * {
+ *   odometry.update();
+ * }
+ * ~~~
+ *
+ * Each update moves the position by the average distance traveled by the
+ * two tracks, in the direction halfway between the old and new headings.
+ * The heading comes from the difference between the tracks, or from a gyro
+ * heading if you pass one to update().  Tracks slip when the robot turns, so
+ * the gyro heading is usually much more accurate.
+ *
+ * All of the calculations use integers, and the sines and cosines come from
+ * Zumo32U4Trig, so an update takes tens of microseconds.  The position is
+ * kept with 8 fractional bits.
+ *
+ * Headings use the same convention as `turnAngle` in the TurnSensor.h file
+ * from the MazeSolver example: a 32-bit number where 0x20000000 represents
+ * 45 degrees counter-clockwise, so that it wraps around at 360 degrees. */
+class Zumo32U4Odometry
+{
+public:
+
+    Zumo32U4Odometry();
+
+    /*! \brief Sets the dimensions of the robot.
+     *
+     * \param countsPerMeter The number of encoder counts per meter of travel.
+     *   The default, 7425, is for 75:1 motors.  See
+     *   Zumo32U4Drive::setGeometry().
+     * \param trackWidthMm The distance between the centers of the tracks,
+     *   in millimeters.  The default is 85. */
+    void setGeometry(uint16_t countsPerMeter, uint16_t trackWidthMm);
+
+    /*! \brief Sets the pose and starts measuring from the current encoder
+     * counts.
+     *
+     * \param xMm The x coordinate, in millimeters.
+     * \param yMm The y coordinate, in millimeters.
+     * \param heading The heading. */
+    void reset(int32_t xMm = 0, int32_t yMm = 0, uint32_t heading = 0);
+
+    /*! \brief Updates the pose with the change in the encoder counts since the
+     * last call to reset() or update().
+     *
+     * This reads Zumo32U4Encoders, but does not reset the counts. */
+    void update();
+
+    /*! \brief Updates the pose with the specified changes in the encoder
+     * counts.
+     *
+     * Use this if your sketch already reads the encoders, for example with
+     * Zumo32U4Encoders::getCountsAndResetLeft().  The changes should be
+     * less than 1000 counts, so call this often enough that the robot does
+     * not travel more than about 10 cm between calls. */
+    void update(int16_t deltaLeft, int16_t deltaRight);
+
+    /*! \brief Updates the pose with the specified changes in the encoder
+     * counts and a gyro heading.
+     *
+     * The heading of the robot follows the changes in \p gyroHeading instead
+     * of the difference between the tracks.  The gyro heading does not need
+     * to start at the same value as the pose heading.
+     *
+     * \param deltaLeft The change in the left encoder count.
+     * \param deltaRight The change in the right encoder count.
+     * \param gyroHeading The current heading from the gyro, for example
+     *   `turnAngle` from TurnSensor.h. */
+    void update(int16_t deltaLeft, int16_t deltaRight, uint32_t gyroHeading);
+
+    /*! \brief Returns the x coordinate, in millimeters. */
+    int32_t getX() const
+    {
+        return x >> 8;
+    }
+
+    /*! \brief Returns the y coordinate, in millimeters. */
+    int32_t getY() const
+    {
+        return y >> 8;
+    }
+
+    /*! \brief Returns the heading, where 0x20000000 represents 45
+     * degrees. */
+    uint32_t getHeading() const
+    {
+        return heading;
+    }
+
+    /*! \brief Returns the heading in degrees, from -180 to 179. */
+    int16_t getHeadingDegrees() const
+    {
+        return ((int32_t)heading >> 16) * 360 >> 16;
+    }
+
+private:
+
+    // Moves the position and sets the new heading.
+    void move(int16_t deltaLeft, int16_t deltaRight, uint32_t newHeading);
+
+    uint16_t mmPerCount;     // mm << 16
+    uint32_t anglePerCount;  // heading units per count of difference
+
+    int32_t x;  // mm << 8
+    int32_t y;  // mm << 8
+    uint32_t heading;
+
+    // The difference between the pose heading and the gyro heading.
+    uint32_t gyroOffset;
+    bool gyroStarted;
+
+    bool countsStarted;
+    int16_t lastCountsLeft;
+    int16_t lastCountsRight;
+};
@@ -0,0 +1,338 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/** \file Zumo32U4ProximitySensorsStatic.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <FastGPIO.h>
+#include <Zumo32U4IRPulses.h>
+#include <Zumo32U4ProximitySensors.h>
+
+/** \cond */
+// Turns off the line sensor emitters, or does nothing if there is no emitter
+// pin.
+template <uint8_t pin> struct Zumo32U4ProximityEmitterPin
+{
+    static bool off() { FastGPIO::Pin<pin>::setOutputLow(); return true; }
+};
+
+template <> struct Zumo32U4ProximityEmitterPin<SENSOR_NO_PIN>
+{
+    static bool off() { return false; }
+};
+/** \endcond */
+
+/** \brief Gets readings from proximity sensors whose pins are known at
+ * compile time, without using dynamic memory.
+ *
+ * This class does the same job as Zumo32U4ProximitySensors and has the same
+ * functions for reading the sensors and getting the results, but the sensor
+ * pins and the line sensor emitter pin are template parameters:
+ *
+ * ~~~{.cpp}
+ * Zumo32U4ProximitySensorsStatic3 proxSensors;
+ *
+ * void loop()
+ * {
+ *   proxSensors.read();
+ *   uint8_t left = proxSensors.countsFrontWithLeftLeds();
+ *   // ...
+ * }
+ * ~~~
+ *
+ * Zumo32U4ProximitySensors allocates memory with `realloc()` for its pin list
+ * and brightness levels, and the first call to its read() function allocates
+ * the default levels, so dynamic memory gets used in the middle of a run.  This
+ * class instead keeps its readings in arrays that are sized at compile time,
+ * and it uses a pointer to a constant table for the brightness levels, so it
+ * never allocates memory.  The sensor pins are read with FastGPIO instead of
+ * `digitalRead()` with run-time bounds checks, so each sample of the sensors
+ * takes a few instructions.
+ *
+ * The typedefs Zumo32U4ProximitySensorsStatic3 and
+ * Zumo32U4ProximitySensorsStaticFront correspond to
+ * Zumo32U4ProximitySensors::initThreeSensors() and
+ * Zumo32U4ProximitySensors::initFrontSensor().
+ *
+ * \tparam lineSensorEmitterPin The pin that controls the line sensor emitters,
+ *   which read() drives low, or #SENSOR_NO_PIN.
+ * \tparam pins The pins of the proximity sensors. */
+template <uint8_t lineSensorEmitterPin, uint8_t... pins>
+class Zumo32U4ProximitySensorsStatic
+{
+public:
+
+    /** The number of sensors. */
+    static const uint8_t sensorCount = sizeof...(pins);
+
+    /** \brief The default brightness levels: 4, 15, 32, 55, 85, and 120.
+     *
+     * See Zumo32U4ProximitySensors for how these were chosen. */
+    static constexpr uint16_t defaultBrightnessLevels[6] =
+        { 4, 15, 32, 55, 85, 120 };
+
+    Zumo32U4ProximitySensorsStatic()
+    {
+        levels = defaultBrightnessLevels;
+        numLevels = sizeof(defaultBrightnessLevels) / sizeof(uint16_t);
+        period = Zumo32U4ProximitySensors::defaultPeriod;
+        pulseOnTimeUs = Zumo32U4ProximitySensors::defaultPulseOnTimeUs;
+        pulseOffTimeUs = Zumo32U4ProximitySensors::defaultPulseOffTimeUs;
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            withLeftLeds[i] = withRightLeds[i] = 0;
+        }
+    }
+
+    /** \brief Returns the number of sensors. */
+    uint8_t getNumSensors() const
+    {
+        return sensorCount;
+    }
+
+    /** \brief Sets the period used for the IR pulses.
+     *
+     * See Zumo32U4ProximitySensors::setPeriod(). */
+    void setPeriod(uint16_t period)
+    {
+        this->period = period;
+    }
+
+    /** \brief Sets the sequence of brightness levels used by read().
+     *
+     * Unlike Zumo32U4ProximitySensors::setBrightnessLevels(), this does not
+     * copy the levels, so the array must remain valid while this object is in
+     * use.  A `static const` array is a good choice.
+     *
+     * \param levels A pointer to an array of brightness levels.
+     * \param levelCount The number of brightness levels. */
+    void setBrightnessLevels(const uint16_t * levels, uint8_t levelCount)
+    {
+        this->levels = levels;
+        this->numLevels = levelCount;
+    }
+
+    /** \brief Sets the duration, in microseconds, for each burst of IR pulses
+     * emitted by the read() function. */
+    void setPulseOnTimeUs(uint16_t pulseOnTimeUs)
+    {
+        this->pulseOnTimeUs = pulseOnTimeUs;
+    }
+
+    /** \brief Sets the amount of time, in microseconds, that the read()
+     * function will leave the pulses off before going on to the next step. */
+    void setPulseOffTimeUs(uint16_t pulseOffTimeUs)
+    {
+        this->pulseOffTimeUs = pulseOffTimeUs;
+    }
+
+    /** \brief Returns the number of brightness levels. */
+    uint8_t getNumBrightnessLevels() const
+    {
+        return numLevels;
+    }
+
+    /** \brief Turns the IR emitters for the line sensors off and then delays
+     * for the pulse off time. */
+    void lineSensorEmittersOff()
+    {
+        if (Zumo32U4ProximityEmitterPin<lineSensorEmitterPin>::off())
+        {
+            delayMicroseconds(pulseOffTimeUs);
+        }
+    }
+
+    /** \brief Sets each sensor pin to an input with pull-up resistors
+     * enabled. */
+    void pullupsOn()
+    {
+        (void)expand{ (FastGPIO::Pin<pins>::setInputPulledUp(), 0)... };
+    }
+
+    /** \brief Does a quick digital reading of the specified sensor without
+     * emitting any IR pulses.
+     *
+     * See Zumo32U4ProximitySensors::readBasic().
+     *
+     * \return 1 if the sensor is active, 0 if not or if \p sensorNumber is not
+     * less than the number of sensors. */
+    bool readBasic(uint8_t sensorNumber)
+    {
+        bool active = false;
+        uint8_t i = 0;
+        (void)expand{ (active |= (i++ == sensorNumber &&
+            !FastGPIO::Pin<pins>::isInputHigh()), 0)... };
+        return active;
+    }
+
+    /** \brief Emits IR pulses and gets readings from the sensors.
+     *
+     * This works like Zumo32U4ProximitySensors::read(). */
+    void read()
+    {
+        pullupsOn();
+        lineSensorEmittersOff();
+
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            withLeftLeds[i] = withRightLeds[i] = 0;
+        }
+
+        for (uint8_t i = 0; i < numLevels; i++)
+        {
+            uint16_t brightness = levels[i];
+
+            Zumo32U4IRPulses::start(Zumo32U4IRPulses::Left, brightness, period);
+            delayMicroseconds(pulseOnTimeUs);
+            sample(withLeftLeds);
+            Zumo32U4IRPulses::stop();
+            delayMicroseconds(pulseOffTimeUs);
+
+            Zumo32U4IRPulses::start(Zumo32U4IRPulses::Right, brightness, period);
+            delayMicroseconds(pulseOnTimeUs);
+            sample(withRightLeds);
+            Zumo32U4IRPulses::stop();
+            delayMicroseconds(pulseOffTimeUs);
+        }
+    }
+
+    /** \brief Returns the number of brightness levels for the left LEDs that
+     * activated the specified sensor, or 0 if \p sensorNumber is not less than
+     * the number of sensors. */
+    uint8_t countsWithLeftLeds(uint8_t sensorNumber) const
+    {
+        if (sensorNumber >= sensorCount) { return 0; }
+        return withLeftLeds[sensorNumber];
+    }
+
+    /** \brief Returns the number of brightness levels for the right LEDs that
+     * activated the specified sensor, or 0 if \p sensorNumber is not less than
+     * the number of sensors. */
+    uint8_t countsWithRightLeds(uint8_t sensorNumber) const
+    {
+        if (sensorNumber >= sensorCount) { return 0; }
+        return withRightLeds[sensorNumber];
+    }
+
+    /** \brief Returns the number of brightness levels for the left LEDs that
+     * activated the left proximity sensor (pin 20), or 0 if that pin is not
+     * used. */
+    uint8_t countsLeftWithLeftLeds() const
+    {
+        return countsWithLeftLeds(findIndexForPin(SENSOR_LEFT));
+    }
+
+    /** \brief Returns the number of brightness levels for the right LEDs that
+     * activated the left proximity sensor (pin 20), or 0 if that pin is not
+     * used. */
+    uint8_t countsLeftWithRightLeds() const
+    {
+        return countsWithRightLeds(findIndexForPin(SENSOR_LEFT));
+    }
+
+    /** \brief Returns the number of brightness levels for the left LEDs that
+     * activated the front proximity sensor (pin 22), or 0 if that pin is not
+     * used. */
+    uint8_t countsFrontWithLeftLeds() const
+    {
+        return countsWithLeftLeds(findIndexForPin(SENSOR_FRONT));
+    }
+
+    /** \brief Returns the number of brightness levels for the right LEDs that
+     * activated the front proximity sensor (pin 22), or 0 if that pin is not
+     * used. */
+    uint8_t countsFrontWithRightLeds() const
+    {
+        return countsWithRightLeds(findIndexForPin(SENSOR_FRONT));
+    }
+
+    /** \brief Returns the number of brightness levels for the left LEDs that
+     * activated the right proximity sensor (pin 4), or 0 if that pin is not
+     * used. */
+    uint8_t countsRightWithLeftLeds() const
+    {
+        return countsWithLeftLeds(findIndexForPin(SENSOR_RIGHT));
+    }
+
+    /** \brief Returns the number of brightness levels for the right LEDs that
+     * activated the right proximity sensor (pin 4), or 0 if that pin is not
+     * used. */
+    uint8_t countsRightWithRightLeds() const
+    {
+        return countsWithRightLeds(findIndexForPin(SENSOR_RIGHT));
+    }
+
+    /** \brief Does a quick digital reading of the left sensor (pin 20). */
+    bool readBasicLeft()
+    {
+        return readBasic(findIndexForPin(SENSOR_LEFT));
+    }
+
+    /** \brief Does a quick digital reading of the front sensor (pin 22). */
+    bool readBasicFront()
+    {
+        return readBasic(findIndexForPin(SENSOR_FRONT));
+    }
+
+    /** \brief Does a quick digital reading of the right sensor (pin 4). */
+    bool readBasicRight()
+    {
+        return readBasic(findIndexForPin(SENSOR_RIGHT));
+    }
+
+private:
+
+    // Expands a function call for each pin.  The calls are made in order,
+    // from left to right.
+    typedef int expand[];
+
+    // Increments the count of each sensor that is active.
+    void sample(uint8_t * counts)
+    {
+        uint8_t i = 0;
+        (void)expand{ (counts[i++] += !FastGPIO::Pin<pins>::isInputHigh(), 0)... };
+    }
+
+    // When the argument is a constant, the compiler can do this search at
+    // compile time.
+    static uint8_t findIndexForPin(uint8_t pin)
+    {
+        const uint8_t pinList[] = { pins... };
+        for (uint8_t i = 0; i < sensorCount; i++)
+        {
+            if (pinList[i] == pin) { return i; }
+        }
+        return 255;
+    }
+
+    uint8_t withLeftLeds[sizeof...(pins)];
+    uint8_t withRightLeds[sizeof...(pins)];
+
+    const uint16_t * levels;
+    uint8_t numLevels;
+
+    uint16_t period;
+    uint16_t pulseOnTimeUs;
+    uint16_t pulseOffTimeUs;
+};
+
+template <uint8_t lineSensorEmitterPin, uint8_t... pins>
+constexpr uint16_t Zumo32U4ProximitySensorsStatic<lineSensorEmitterPin,
+    pins...>::defaultBrightnessLevels[6];
+
+/** \brief Reads the left, front, and right proximity sensors like
+ * Zumo32U4ProximitySensors::initThreeSensors(), but without dynamic memory.
+ *
+ * For this configuration to work, jumpers on the front sensor array must be
+ * installed in order to connect pin 20 to LFT and connect pin 4 to RGT. */
+typedef Zumo32U4ProximitySensorsStatic<
+    Zumo32U4ProximitySensors::defaultLineSensorEmitterPin,
+    SENSOR_LEFT, SENSOR_FRONT, SENSOR_RIGHT> Zumo32U4ProximitySensorsStatic3;
+
+/** \brief Reads just the front proximity sensor like
+ * Zumo32U4ProximitySensors::initFrontSensor(), but without dynamic memory. */
+typedef Zumo32U4ProximitySensorsStatic<
+    Zumo32U4ProximitySensors::defaultLineSensorEmitterPin,
+    SENSOR_FRONT> Zumo32U4ProximitySensorsStaticFront;
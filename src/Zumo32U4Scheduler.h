@@ -0,0 +1,266 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Scheduler.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/*! \brief Runs several tasks at fixed rates from your main loop.
+ *
+ * Robot programs often need to do several things at different rates: read the
+ * sensors, update a controller, refresh the display, and send data over USB.
+ * This class lets you register a function for each of those jobs with
+ * addTask(), along with how often it should run and its priority.  Then you
+ * call run() from `loop()`, and it calls each task when it is due:
+ *
+ * ~~~{.cpp}
+ * Zumo32U4Scheduler<3> scheduler;
+ *
+ * void setup()
+ * {
+ *   scheduler.addTask(readSensors, 5, 0, F("sensors"));
+ *   scheduler.addTask(control, 10, 1, F("control"));
+ *   scheduler.addTask(updateDisplay, 100, 2, F("display"));
+ * }
+ *
+ * void loop()
+ * {
+ *   scheduler.run();
+ * }
+ * ~~~
+ *
+ * The scheduler is cooperative: each task runs until it returns, so a task
+ * that takes a long time delays the others, and tasks should avoid long
+ * blocking calls.  When several tasks are due at the same time, the one with
+ * the highest priority (the lowest priority number) runs first.  Each call to
+ * run() runs every task that was due when it started at most once, so
+ * `loop()` gets control back even if some tasks cannot keep up.
+ *
+ * Task times are based on `millis()`, which is updated by the Timer 0
+ * overflow interrupt.
+ *
+ * Overruns
+ * ========
+ *
+ * If a task starts so late that it missed one or more whole periods, the
+ * missed runs are skipped instead of being run back to back, and the task's
+ * overrun count is incremented.  A task that takes longer to run than its own
+ * period is also counted as an overrun.
+ *
+ * Utilization
+ * ===========
+ *
+ * The scheduler measures how long each task runs with `micros()`.
+ * getUtilization() and print() report the fraction of time spent in each task
+ * since the statistics were last reset, which shows how much spare CPU time
+ * your program has.
+ *
+ * \tparam taskCount The maximum number of tasks.  Each task uses 22 bytes of
+ * RAM. */
+template <uint8_t taskCount = 4> class Zumo32U4Scheduler
+{
+public:
+
+    Zumo32U4Scheduler()
+    {
+        numTasks = 0;
+        resetStatistics();
+    }
+
+    /*! \brief Registers a task.
+     *
+     * \param function The function to call.
+     * \param periodMs How often to call the function, in milliseconds.  The
+     *   minimum is 1 (0 is treated as 1) and the maximum is 32767.
+     * \param priority The priority of the task.  Lower numbers are higher
+     *   priorities.
+     * \param name An optional name for the task, which is used by print().
+     *
+     * \return The number of the task, or 255 if there is no room for more
+     * tasks. */
+    uint8_t addTask(void (*function)(), uint16_t periodMs, uint8_t priority = 0,
+        const __FlashStringHelper * name = NULL)
+    {
+        if (numTasks >= taskCount) { return 255; }
+        Task & t = tasks[numTasks];
+        t.function = function;
+        t.periodMs = periodMs ? periodMs : 1;
+        t.priority = priority;
+        t.name = name;
+        t.enabled = true;
+        t.nextRunMs = millis();
+        resetTask(t);
+        return numTasks++;
+    }
+
+    /*! \brief Enables or disables a task.
+     *
+     * When a task is enabled, it is scheduled to run as soon as possible. */
+    void setTaskEnabled(uint8_t task, bool enabled)
+    {
+        if (task >= numTasks) { return; }
+        if (enabled && !tasks[task].enabled)
+        {
+            tasks[task].nextRunMs = millis();
+        }
+        tasks[task].enabled = enabled;
+    }
+
+    /*! \brief Changes the period of a task.  A period of 0 is treated as
+     * 1. */
+    void setTaskPeriod(uint8_t task, uint16_t periodMs)
+    {
+        if (task >= numTasks) { return; }
+        tasks[task].periodMs = periodMs ? periodMs : 1;
+    }
+
+    /*! \brief Runs the tasks that are due, in priority order.
+     *
+     * This should be called from `loop()` as often as possible.  Each task
+     * runs at most once per call, and tasks that become due while other tasks
+     * are running wait for the next call.
+     *
+     * \return The number of tasks that ran. */
+    uint8_t run()
+    {
+        // Every task that runs is scheduled for after this time, because its
+        // period is at least 1 ms and missed runs are skipped, so each task
+        // can only be picked once.
+        uint16_t now = millis();
+
+        uint8_t ranCount = 0;
+        while (true)
+        {
+            // Find the due task with the highest priority.
+            uint8_t best = 255;
+            for (uint8_t i = 0; i < numTasks; i++)
+            {
+                Task & t = tasks[i];
+                if (!t.enabled || (int16_t)(now - t.nextRunMs) < 0) { continue; }
+                if (best == 255 || t.priority < tasks[best].priority)
+                {
+                    best = i;
+                }
+            }
+            if (best == 255) { return ranCount; }
+
+            Task & t = tasks[best];
+            uint16_t lateMs = now - t.nextRunMs;
+            t.nextRunMs += t.periodMs;
+            if (lateMs >= t.periodMs)
+            {
+                // Skip the runs we missed.
+                t.overrunCount++;
+                t.nextRunMs += (lateMs / t.periodMs) * t.periodMs;
+            }
+
+            uint32_t start = micros();
+            t.function();
+            uint32_t duration = micros() - start;
+
+            if (duration > (uint32_t)t.periodMs * 1000) { t.overrunCount++; }
+            if (duration > t.maxDurationUs) { t.maxDurationUs = duration; }
+            t.busyUs += duration;
+            if (t.runCount != 0xFFFF) { t.runCount++; }
+            ranCount++;
+        }
+    }
+
+    /*! \brief Clears the run counts, overrun counts, and utilization
+     * statistics of all tasks. */
+    void resetStatistics()
+    {
+        statisticsStartUs = micros();
+        for (uint8_t i = 0; i < numTasks; i++)
+        {
+            resetTask(tasks[i]);
+        }
+    }
+
+    /*! \brief Returns the number of times the task has run. */
+    uint16_t getRunCount(uint8_t task) const
+    {
+        if (task >= numTasks) { return 0; }
+        return tasks[task].runCount;
+    }
+
+    /*! \brief Returns the number of overruns detected for the task. */
+    uint16_t getOverrunCount(uint8_t task) const
+    {
+        if (task >= numTasks) { return 0; }
+        return tasks[task].overrunCount;
+    }
+
+    /*! \brief Returns the longest time the task has taken to run, in
+     * microseconds. */
+    uint32_t getMaxDurationUs(uint8_t task) const
+    {
+        if (task >= numTasks) { return 0; }
+        return tasks[task].maxDurationUs;
+    }
+
+    /*! \brief Returns the fraction of time spent running the task since the
+     * statistics were last reset, in tenths of a percent (0 to 1000). */
+    uint16_t getUtilization(uint8_t task) const
+    {
+        if (task >= numTasks) { return 0; }
+        uint32_t elapsedUs = micros() - statisticsStartUs;
+        if (elapsedUs < 1000) { return 0; }
+        return tasks[task].busyUs / (elapsedUs / 1000);
+    }
+
+    /*! \brief Prints a report with one line of comma-separated values per
+     * task, in this format:
+     *
+     *     name,periodMs,runs,overruns,maxUs,utilization
+     *
+     * The utilization is in tenths of a percent. */
+    void print(Print & out) const
+    {
+        for (uint8_t i = 0; i < numTasks; i++)
+        {
+            if (tasks[i].name) { out.print(tasks[i].name); }
+            else { out.print(i); }
+            out.print(',');
+            out.print(tasks[i].periodMs);
+            out.print(',');
+            out.print(getRunCount(i));
+            out.print(',');
+            out.print(getOverrunCount(i));
+            out.print(',');
+            out.print(getMaxDurationUs(i));
+            out.print(',');
+            out.println(getUtilization(i));
+        }
+    }
+
+private:
+
+    struct Task
+    {
+        void (*function)();
+        const __FlashStringHelper * name;
+        uint16_t periodMs;
+        uint16_t nextRunMs;
+        uint8_t priority;
+        bool enabled;
+        uint16_t runCount;
+        uint16_t overrunCount;
+        uint32_t maxDurationUs;
+        uint32_t busyUs;
+    };
+
+    static void resetTask(Task & t)
+    {
+        t.runCount = 0;
+        t.overrunCount = 0;
+        t.maxDurationUs = 0;
+        t.busyUs = 0;
+    }
+
+    Task tasks[taskCount];
+    uint8_t numTasks;
+    uint32_t statisticsStartUs;
+};
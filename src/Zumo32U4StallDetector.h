@@ -0,0 +1,313 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4StallDetector.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <Zumo32U4Encoders.h>
+#include <Zumo32U4Motors.h>
+
+/*! \brief Detects stalled, slipping, and free-wheeling tracks by comparing
+ * the motor speeds with the encoder counts.
+ *
+ * When the Zumo pushes against an opponent or a wall, the motors can stall:
+ * they are driven hard but the tracks barely turn.  When a track loses
+ * traction, it turns faster than the other one.  When the robot is picked up
+ * or tipped onto its back, the tracks spin freely, faster than they would on
+ * the ground.  This class tells these situations apart by comparing the
+ * speed of each track, measured with Zumo32U4Encoders, with the speed you
+ * would expect from the motor speed last set with Zumo32U4Motors.
+ *
+ * You call update() every control tick, for example every 10 ms.  It returns
+ * the events that started during that tick, so your strategy code can react
+ * right away:
+ *
+ * ~~~{.cpp}
+ * Zumo32U4StallDetector<> stallDetector;
+ *
+ * void controlTask()  // every 10 ms
+ * {
+ *   // ... set motor speeds ...
+ *   uint8_t events = stallDetector.update();
+ *   if (events & stallDetector.StallLeft) { ... }
+ * }
+ * ~~~
+ *
+ * The comparisons use the totals over the last few ticks, so a single
+ * noisy reading does not cause an event.  Each update takes a few dozen
+ * additions and multiplications and one 32-bit division per track; the
+ * factors that convert motor speeds to encoder counts are only recomputed
+ * when the length of the window in milliseconds or the PWM mode of
+ * Zumo32U4Motors changes, which does not happen with a steady tick.  The
+ * totals are only evaluated once the window is full, so events can start no
+ * sooner than one window after the detector is created or reset().
+ *
+ * The expected speed is the motor speed divided by
+ * Zumo32U4Motors::getMaxSpeed() times the speed that a track reaches on the
+ * ground at full power, which you can set with setGroundSpeed().  A track is:
+ *
+ * - \b stalled if its motor speed is at least 20% of the maximum but it is
+ *   turning at less than 25% of the expected speed,
+ * - \b slipping if its speed as a fraction of the expected speed differs from
+ *   that of the other track by more than 40 percentage points, and
+ * - \b free-wheeling if it is turning at more than 115% of the expected
+ *   speed.
+ *
+ * These percentages can be changed with setThresholds().
+ *
+ * This class assumes that positive motor speeds make the encoder counts
+ * increase, which is true unless a motor has been flipped.
+ *
+ * \tparam windowSize The number of ticks to total.  Each tick uses 9 bytes
+ * of RAM. */
+template <uint8_t windowSize = 8> class Zumo32U4StallDetector
+{
+public:
+
+    /*! Bits that represent the events and states reported by this class. */
+    enum Event
+    {
+        /*! The left track is stalled. */
+        StallLeft = 1,
+
+        /*! The right track is stalled. */
+        StallRight = 2,
+
+        /*! One track is turning faster, relative to its motor speed, than the
+         * other one. */
+        Slip = 4,
+
+        /*! Both tracks are turning faster than they could on the ground. */
+        FreeWheel = 8,
+    };
+
+    Zumo32U4StallDetector()
+    {
+        setGroundSpeed(7300);
+        setThresholds(25, 40, 115);
+        reset();
+    }
+
+    /*! \brief Sets the speed that a track reaches on the ground when its motor
+     * is at full speed, in encoder counts per second.
+     *
+     * The default, 7300, is for 75:1 motors.  To measure it, drive straight
+     * at full speed for a second and divide the change in the encoder counts
+     * by the time. */
+    void setGroundSpeed(uint16_t countsPerSecond)
+    {
+        groundSpeed = countsPerSecond;
+        scaleMaxSpeed = 0;
+    }
+
+    /*! \brief Sets the thresholds for the events, in percent of the expected
+     * speed.
+     *
+     * \param stallPercent A track is stalled below this speed.
+     * \param slipPercent The tracks are slipping if their speeds differ by more
+     *   than this.
+     * \param freePercent The tracks are free-wheeling above this speed. */
+    void setThresholds(uint8_t stallPercent, uint8_t slipPercent,
+        uint8_t freePercent)
+    {
+        this->stallPercent = stallPercent;
+        this->slipPercent = slipPercent;
+        this->freePercent = freePercent;
+    }
+
+    /*! \brief Clears the window and the current state.
+     *
+     * Call this after a long break between calls to update(). */
+    void reset()
+    {
+        for (uint8_t i = 0; i < windowSize; i++)
+        {
+            samples[i].countsLeft = samples[i].countsRight = 0;
+            samples[i].commandLeft = samples[i].commandRight = 0;
+            samples[i].time = 0;
+        }
+        sumCountsLeft = sumCountsRight = 0;
+        sumCommandLeft = sumCommandRight = 0;
+        sumTime = 0;
+        index = 0;
+        count = 0;
+        state = 0;
+        lastCountsLeft = Zumo32U4Encoders::getCountsLeft();
+        lastCountsRight = Zumo32U4Encoders::getCountsRight();
+        lastUpdateMs = millis();
+        scaleMaxSpeed = 0;
+    }
+
+    /*! \brief Reads the encoders and motor speeds and updates the state.
+     *
+     * \return A bitmask of the events (see #Event) that started since the last
+     * call. */
+    uint8_t update()
+    {
+        // Ticks longer than 100 ms are counted as 100 ms so that the samples
+        // fit in 16 bits.
+        uint16_t now = millis();
+        uint16_t elapsed = now - lastUpdateMs;
+        uint8_t dt = elapsed > 100 ? 100 : elapsed;
+        lastUpdateMs = now;
+
+        // These differences are done with unsigned numbers because signed
+        // integer overflow is undefined behavior in C++.
+        int16_t countsLeft = Zumo32U4Encoders::getCountsLeft();
+        int16_t countsRight = Zumo32U4Encoders::getCountsRight();
+        int16_t deltaLeft = (uint16_t)countsLeft - (uint16_t)lastCountsLeft;
+        int16_t deltaRight = (uint16_t)countsRight - (uint16_t)lastCountsRight;
+        lastCountsLeft = countsLeft;
+        lastCountsRight = countsRight;
+
+        // The motor speed times the time, so that each tick counts in
+        // proportion to how long it was.
+        int16_t commandLeft = (int32_t)Zumo32U4Motors::getLeftSpeed() * dt / 4;
+        int16_t commandRight = (int32_t)Zumo32U4Motors::getRightSpeed() * dt / 4;
+
+        // Replace the oldest sample in the window.
+        Sample & s = samples[index];
+        sumCountsLeft += deltaLeft - s.countsLeft;
+        sumCountsRight += deltaRight - s.countsRight;
+        sumCommandLeft += commandLeft - s.commandLeft;
+        sumCommandRight += commandRight - s.commandRight;
+        sumTime += dt - s.time;
+        s.countsLeft = deltaLeft;
+        s.countsRight = deltaRight;
+        s.commandLeft = commandLeft;
+        s.commandRight = commandRight;
+        s.time = dt;
+        if (++index >= windowSize) { index = 0; }
+        if (count < windowSize) { count++; }
+
+        uint16_t maxSpeed = Zumo32U4Motors::getMaxSpeed();
+        if (maxSpeed != scaleMaxSpeed || sumTime != scaleTime)
+        {
+            updateScale(maxSpeed);
+        }
+
+        uint8_t newState = 0;
+        if (count >= windowSize) { newState = evaluate(); }
+        uint8_t started = newState & ~state;
+        state = newState;
+        return started;
+    }
+
+    /*! \brief Returns a bitmask of the events (see #Event) that are currently
+     * happening. */
+    uint8_t getState() const
+    {
+        return state;
+    }
+
+    /*! \brief Returns true if either track is stalled. */
+    bool isStalled() const
+    {
+        return state & (StallLeft | StallRight);
+    }
+
+    /*! \brief Returns true if the tracks are slipping. */
+    bool isSlipping() const
+    {
+        return state & Slip;
+    }
+
+    /*! \brief Returns true if both tracks are free-wheeling. */
+    bool isFreeWheeling() const
+    {
+        return state & FreeWheel;
+    }
+
+private:
+
+    struct Sample
+    {
+        int16_t countsLeft;
+        int16_t countsRight;
+        int16_t commandLeft;
+        int16_t commandRight;
+        uint8_t time;
+    };
+
+    // Recomputes the factors used by percentOfExpected() for the given
+    // maximum motor speed and the current sumTime.
+    void updateScale(uint16_t maxSpeed)
+    {
+        scaleMaxSpeed = maxSpeed;
+        scaleTime = sumTime;
+
+        // Require an average motor speed of at least 20% of the maximum.
+        minimumCommand = (uint32_t)maxSpeed * sumTime / 20;
+
+        // The expected counts are sumCommand * 4 / maxSpeed * groundSpeed /
+        // 1000, because sumCommand is in motor speed units times ms / 4, so
+        // the percentage is counts * 25000 * maxSpeed / groundSpeed /
+        // sumCommand.  Limiting the scale to 16 bits keeps counts times the
+        // scale in 32 bits.
+        uint32_t scale = groundSpeed == 0 ? 0xFFFF :
+            25000UL * maxSpeed / groundSpeed;
+        percentScale = scale > 0xFFFF ? 0xFFFF : scale;
+    }
+
+    // Returns the measured counts as a percentage of the expected counts, or
+    // -1 if the motor speed was too low to tell.
+    int16_t percentOfExpected(int16_t counts, int32_t sumCommand) const
+    {
+        if (sumCommand == 0 || (uint32_t)labs(sumCommand) < minimumCommand)
+        {
+            return -1;
+        }
+
+        int32_t percent = (int32_t)counts * percentScale / sumCommand;
+        if (percent < 0) { percent = 0; }
+        if (percent > 1000) { percent = 1000; }
+        return percent;
+    }
+
+    uint8_t evaluate() const
+    {
+        uint8_t result = 0;
+
+        int16_t left = percentOfExpected(sumCountsLeft, sumCommandLeft);
+        int16_t right = percentOfExpected(sumCountsRight, sumCommandRight);
+
+        if (left >= 0 && left < stallPercent) { result |= StallLeft; }
+        if (right >= 0 && right < stallPercent) { result |= StallRight; }
+
+        if (left >= 0 && right >= 0)
+        {
+            if (abs(left - right) > slipPercent) { result |= Slip; }
+            if (left > freePercent && right > freePercent)
+            {
+                result |= FreeWheel;
+            }
+        }
+
+        return result;
+    }
+
+    Sample samples[windowSize];
+    int16_t sumCountsLeft;
+    int16_t sumCountsRight;
+    int32_t sumCommandLeft;
+    int32_t sumCommandRight;
+    uint16_t sumTime;
+    uint8_t index;
+    uint8_t count;
+    uint8_t state;
+
+    int16_t lastCountsLeft;
+    int16_t lastCountsRight;
+    uint16_t lastUpdateMs;
+
+    uint16_t groundSpeed;
+    uint16_t scaleMaxSpeed;  // The maximum speed when the scale was computed.
+    uint16_t scaleTime;      // sumTime when the scale was computed.
+    uint32_t minimumCommand;
+    uint16_t percentScale;
+    uint8_t stallPercent;
+    uint8_t slipPercent;
+    uint8_t freePercent;
+};
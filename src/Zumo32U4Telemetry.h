@@ -0,0 +1,256 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Telemetry.h */
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <util/crc16.h>
+#include <Zumo32U4IMU.h>
+#include <Zumo32U4ProximitySensors.h>
+
+/*! \brief Streams sensor and motor data over USB as compact binary records.
+ *
+ * Formatting readings as text with `Serial.print()` takes a long time and can
+ * slow down your control loop.  This class instead packs each reading into a
+ * small binary frame, stores it in a ring buffer in RAM, and sends the buffered
+ * bytes over the serial port from update() without ever waiting for the port.
+ * If the buffer is full, new records are dropped instead of blocking.
+ *
+ * Frame format
+ * ============
+ *
+ * Every frame has this format, with multi-byte values in little-endian order:
+ *
+ * | Bytes | Contents                                                   |
+ * |-------|------------------------------------------------------------|
+ * | 1     | #syncByte (0xA5)                                           |
+ * | 1     | Record type (see RecordType)                               |
+ * | 1     | Sequence number                                            |
+ * | 2     | Time in milliseconds (lower 16 bits of `millis()`)         |
+ * | n     | Payload, whose length depends only on the record type      |
+ * | 2     | CRC-16 of the type, sequence number, time, and payload     |
+ *
+ * The CRC is the CRC-CCITT computed by `_crc_ccitt_update()` from avr-libc:
+ * polynomial 0x8408 (reflected 0x1021), initial value 0xFFFF, with no final
+ * XOR.
+ *
+ * The sequence number increases by one for every record you try to send,
+ * including records that get dropped because the buffer is full, so gaps in
+ * the sequence show where data was lost.
+ *
+ * The payloads are:
+ *
+ * * #Line: 5 unsigned 16-bit line sensor readings.  Unused entries are 0.
+ * * #Proximity: 6 unsigned 8-bit counts: left sensor with left LEDs, left
+ *   sensor with right LEDs, front sensor with left LEDs, front sensor with
+ *   right LEDs, right sensor with left LEDs, right sensor with right LEDs.
+ * * #Imu: 9 signed 16-bit readings: accelerometer X, Y, Z, gyro X, Y, Z,
+ *   magnetometer X, Y, Z.
+ * * #Encoders: 2 signed 16-bit encoder counts: left, right.
+ * * #Motors: 2 signed 16-bit motor speeds: left, right.
+ *
+ * \tparam bufferSize The size of the ring buffer in bytes.  It must be larger
+ * than the largest frame (25 bytes). */
+template <uint16_t bufferSize = 128> class Zumo32U4Telemetry
+{
+public:
+
+    /*! The first byte of every frame. */
+    static const uint8_t syncByte = 0xA5;
+
+    /*! The types of records that can be sent. */
+    enum RecordType
+    {
+        /*! Line sensor readings. */
+        Line = 1,
+
+        /*! Proximity sensor counts. */
+        Proximity = 2,
+
+        /*! Accelerometer, gyro, and magnetometer readings. */
+        Imu = 3,
+
+        /*! Encoder counts. */
+        Encoders = 4,
+
+        /*! Motor speeds. */
+        Motors = 5,
+    };
+
+    Zumo32U4Telemetry()
+    {
+        head = tail = 0;
+        sequence = 0;
+        droppedCount = 0;
+    }
+
+    /*! \brief Queues a record with line sensor readings.
+     *
+     * \param values A pointer to the readings.
+     * \param count The number of readings.  At most 5 are sent.
+     *
+     * \return True if the record was queued, false if it was dropped because
+     * the buffer is full. */
+    bool sendLine(const uint16_t * values, uint8_t count)
+    {
+        if (!beginFrame(Line, 10)) { return false; }
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            writeWord(i < count ? values[i] : 0);
+        }
+        endFrame();
+        return true;
+    }
+
+    /*! \brief Queues a record with the counts from the last call to
+     * Zumo32U4ProximitySensors::read(). */
+    bool sendProximity(const Zumo32U4ProximitySensors & prox)
+    {
+        if (!beginFrame(Proximity, 6)) { return false; }
+        writeByte(prox.countsLeftWithLeftLeds());
+        writeByte(prox.countsLeftWithRightLeds());
+        writeByte(prox.countsFrontWithLeftLeds());
+        writeByte(prox.countsFrontWithRightLeds());
+        writeByte(prox.countsRightWithLeftLeds());
+        writeByte(prox.countsRightWithRightLeds());
+        endFrame();
+        return true;
+    }
+
+    /*! \brief Queues a record with the latest readings stored in
+     * Zumo32U4IMU::a, Zumo32U4IMU::g, and Zumo32U4IMU::m. */
+    bool sendImu(const Zumo32U4IMU & imu)
+    {
+        if (!beginFrame(Imu, 18)) { return false; }
+        writeVector(imu.a);
+        writeVector(imu.g);
+        writeVector(imu.m);
+        endFrame();
+        return true;
+    }
+
+    /*! \brief Queues a record with encoder counts. */
+    bool sendEncoders(int16_t left, int16_t right)
+    {
+        if (!beginFrame(Encoders, 4)) { return false; }
+        writeWord(left);
+        writeWord(right);
+        endFrame();
+        return true;
+    }
+
+    /*! \brief Queues a record with motor speeds. */
+    bool sendMotors(int16_t left, int16_t right)
+    {
+        if (!beginFrame(Motors, 4)) { return false; }
+        writeWord(left);
+        writeWord(right);
+        endFrame();
+        return true;
+    }
+
+    /*! \brief Sends as many buffered bytes as the port can accept right now.
+     *
+     * You should call this once per loop.  It never waits: it only writes
+     * as many bytes as the port's `availableForWrite()` function says it can
+     * accept without blocking.  The default port is the USB virtual serial
+     * port, `Serial`.
+     *
+     * \return The number of bytes still waiting in the buffer. */
+    uint16_t update(Print & port = Serial)
+    {
+        int room = port.availableForWrite();
+        while (room > 0 && tail != head)
+        {
+            // Write the largest contiguous piece of the buffer that fits.
+            uint16_t end = head > tail ? head : bufferSize;
+            uint16_t length = end - tail;
+            if (length > (uint16_t)room) { length = room; }
+            port.write(buffer + tail, length);
+            tail += length;
+            if (tail == bufferSize) { tail = 0; }
+            room -= length;
+        }
+        return getBufferedCount();
+    }
+
+    /*! \brief Returns the number of bytes waiting to be sent. */
+    uint16_t getBufferedCount() const
+    {
+        return head >= tail ? head - tail : bufferSize - tail + head;
+    }
+
+    /*! \brief Returns the number of records that were dropped because the
+     * buffer was full. */
+    uint16_t getDroppedCount() const
+    {
+        return droppedCount;
+    }
+
+private:
+
+    // Sync, type, sequence, and time before the payload; CRC after it.
+    static const uint8_t overhead = 7;
+
+    bool beginFrame(uint8_t type, uint8_t payloadLength)
+    {
+        uint8_t seq = sequence++;
+
+        // One byte of the buffer always stays unused so that a full buffer can
+        // be told apart from an empty one.
+        if (bufferSize - 1 - getBufferedCount() < overhead + payloadLength)
+        {
+            droppedCount++;
+            return false;
+        }
+
+        put(syncByte);
+        crc = 0xFFFF;
+        writeByte(type);
+        writeByte(seq);
+        writeWord(millis());
+        return true;
+    }
+
+    void endFrame()
+    {
+        uint16_t c = crc;
+        put(c & 0xFF);
+        put(c >> 8);
+    }
+
+    void writeByte(uint8_t b)
+    {
+        crc = _crc_ccitt_update(crc, b);
+        put(b);
+    }
+
+    void writeWord(uint16_t w)
+    {
+        writeByte(w & 0xFF);
+        writeByte(w >> 8);
+    }
+
+    void writeVector(const Zumo32U4IMU::vector<int16_t> & v)
+    {
+        writeWord(v.x);
+        writeWord(v.y);
+        writeWord(v.z);
+    }
+
+    void put(uint8_t b)
+    {
+        buffer[head] = b;
+        head++;
+        if (head == bufferSize) { head = 0; }
+    }
+
+    uint8_t buffer[bufferSize];
+    uint16_t head;
+    uint16_t tail;
+    uint16_t crc;
+    uint8_t sequence;
+    uint16_t droppedCount;
+};
@@ -0,0 +1,146 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4TiltMonitor.h>
+#include <Zumo32U4IMU.h>
+#include <Zumo32U4Motors.h>
+#include <Zumo32U4Trig.h>
+
+// The reading of 1 g at +/- 2 g full scale.
+static const int32_t oneG = 16384;
+
+// The robot counts as lifted if it is accelerating upward at more than a
+// quarter of a g, or if it is falling, so that the total acceleration is less
+// than half of a g.  The second limit is squared so that no square root is
+// needed.
+static const int16_t liftZ = oneG * 5 / 4;
+static const uint32_t fallingSquared = (oneG / 2) * (oneG / 2);
+
+Zumo32U4TiltMonitor::Zumo32U4TiltMonitor()
+{
+    setAngles(5, 25);
+    setSpinRate(1286);
+    setTurnRate(18900);
+    setGyroOffset(0);
+    reset();
+}
+
+void Zumo32U4TiltMonitor::setAngles(uint8_t slopeDegrees, uint8_t liftDegrees)
+{
+    slopeAngle = (uint32_t)slopeDegrees * 65536 / 360;
+    liftAngle = (uint32_t)liftDegrees * 65536 / 360;
+}
+
+void Zumo32U4TiltMonitor::reset()
+{
+    accStarted = false;
+    gyroStarted = false;
+    accX = accY = accZ = 0;
+    yawRate = 0;
+    tiltAngle = 0;
+    state = 0;
+}
+
+uint8_t Zumo32U4TiltMonitor::update(Zumo32U4IMU & imu)
+{
+    uint8_t started = 0;
+    if (imu.accDataReady())
+    {
+        imu.readAcc();
+        started |= addAccReading(imu.a.x, imu.a.y, imu.a.z);
+    }
+    if (imu.gyroDataReady())
+    {
+        imu.readGyro();
+        started |= addGyroReading(imu.g.z);
+    }
+    return started;
+}
+
+// Moves a filtered reading a quarter of the way toward a new reading, so that
+// vibrations from the motors are smoothed out but a real change shows up
+// within a few readings.
+static int16_t filter(int16_t filtered, int16_t reading)
+{
+    return filtered + ((int32_t)reading - filtered) / 4;
+}
+
+uint8_t Zumo32U4TiltMonitor::addAccReading(int16_t x, int16_t y, int16_t z)
+{
+    if (accStarted)
+    {
+        accX = filter(accX, x);
+        accY = filter(accY, y);
+        accZ = filter(accZ, z);
+    }
+    else
+    {
+        accX = x;
+        accY = y;
+        accZ = z;
+        accStarted = true;
+    }
+
+    // Halve the readings so that the length of the X-Y vector fits in 16
+    // bits.
+    tiltAngle = Zumo32U4Trig::arctangent(
+        Zumo32U4Trig::magnitude(accX / 2, accY / 2), accZ / 2);
+
+    uint32_t totalSquared = (uint32_t)((int32_t)accX * accX) +
+        (uint32_t)((int32_t)accY * accY) + (uint32_t)((int32_t)accZ * accZ);
+
+    uint8_t newState = 0;
+    if (tiltAngle > liftAngle || accZ > liftZ ||
+        totalSquared < fallingSquared)
+    {
+        newState = Lifted;
+    }
+    else if (tiltAngle > slopeAngle)
+    {
+        newState = Slope;
+    }
+    return setState(Lifted | Slope, newState);
+}
+
+uint8_t Zumo32U4TiltMonitor::addGyroReading(int16_t z)
+{
+    int16_t rate = (int32_t)z - gyroOffset;
+    if (gyroStarted)
+    {
+        yawRate = filter(yawRate, rate);
+    }
+    else
+    {
+        yawRate = rate;
+        gyroStarted = true;
+    }
+
+    // The yaw rate that the motors are asking for.  The tracks slip when the
+    // robot turns, so the real rate can be quite a bit lower, and the
+    // allowed difference grows with the commanded rate to allow for that.
+    int32_t difference = (int32_t)Zumo32U4Motors::getRightSpeed() -
+        Zumo32U4Motors::getLeftSpeed();
+    int32_t expected = difference * turnRate /
+        (2 * Zumo32U4Motors::getMaxSpeed());
+    int32_t error = yawRate - expected;
+    if (error < 0) { error = -error; }
+    if (expected < 0) { expected = -expected; }
+
+    uint8_t newState = 0;
+    if (error > spinRate + expected / 2) { newState = Spun; }
+    return setState(Spun, newState);
+}
+
+uint16_t Zumo32U4TiltMonitor::getTiltDirection() const
+{
+    // The accelerometer measures the force holding the robot up.  When the
+    // robot is tilted, the axis pointing toward the higher side points
+    // partly up, so that force leans toward the higher side.
+    return Zumo32U4Trig::arctangent(accY, accX);
+}
+
+uint8_t Zumo32U4TiltMonitor::setState(uint8_t mask, uint8_t newBits)
+{
+    uint8_t started = newBits & ~state;
+    state = (state & ~mask) | newBits;
+    return started;
+}
@@ -0,0 +1,212 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4TiltMonitor.h */
+
+#pragma once
+
+#include <stdint.h>
+
+class Zumo32U4IMU;
+
+/*! \brief Watches the accelerometer and gyro for the robot being lifted,
+ * standing on a slope, or being spun.
+ *
+ * This class keeps a filtered copy of the accelerometer readings, from which
+ * it estimates how far the robot is tilted and which way is uphill, and a
+ * filtered copy of the gyro's Z axis, which tells how fast the robot is
+ * turning.  It checks for the events below every time the IMU has a new
+ * reading instead of once per main loop.  Each filter moves a quarter of the
+ * way toward every new reading, so after a sudden change it takes about three
+ * readings for the filtered value to cross a threshold.
+ *
+ * - \b Lifted: the robot is tilted more than the lift angle (25 degrees by
+ *   default), for example because an opponent's wedge got under it, it is
+ *   accelerating upward at more than a quarter of a g because it is being
+ *   picked up, or it is falling.
+ * - \b Slope: the robot is tilted more than the slope angle (5 degrees by
+ *   default) but less than the lift angle.
+ * - \b Spun: the robot's yaw rate differs from the yaw rate that the motor
+ *   speeds set with Zumo32U4Motors should cause by more than the spin rate
+ *   plus half of the commanded rate, so something other than the motors
+ *   must be turning it.  The extra half allows for the tracks slipping in
+ *   turns.
+ *
+ * ~~~{.cpp}
+ * Zumo32U4IMU imu;
+ * Zumo32U4TiltMonitor tiltMonitor;
+ *
+ * void loop()
+ * {
+ *   uint8_t events = tiltMonitor.update(imu);
+ *   if (events & tiltMonitor.Lifted) { ... }
+ *   // ... the rest of the strategy ...
+ * }
+ * ~~~
+ *
+ * The accelerometer must be set to +/- 2 g full scale, which is what all of
+ * the Zumo32U4IMU configuration functions except configureForBalancing() do.
+ * The default spin rate assumes that the gyro has been set to +/- 2000
+ * degrees per second with Zumo32U4IMU::configureForTurnSensing().  The
+ * accelerometer readings can be at any rate, but
+ * Zumo32U4IMU::configureForCollisionDetection() makes them arrive about 400
+ * times per second instead of the 50 that Zumo32U4IMU::enableDefault() gives,
+ * which shortens the filter's delay to well under 10 ms.
+ *
+ * The tilt is measured from the direction of the total acceleration, so the
+ * robot's own acceleration looks like tilt too: speeding up at 0.1 g looks
+ * like the front has risen by about 6 degrees, and a hard collision can look
+ * like being lifted for a few readings.  Like the FaceUphill example, code
+ * that reacts to slopes works best when the robot moves smoothly.
+ *
+ * Angles use the same convention as Zumo32U4Trig: 65536 is a full turn, and
+ * directions are measured counter-clockwise from straight ahead. */
+class Zumo32U4TiltMonitor
+{
+public:
+
+    /*! Bits that represent the events and states reported by this class. */
+    enum Event
+    {
+        /*! The robot is tilted steeply or being picked up. */
+        Lifted = 1,
+
+        /*! The robot is standing on a slope. */
+        Slope = 2,
+
+        /*! Something other than the motors is turning the robot. */
+        Spun = 4,
+    };
+
+    Zumo32U4TiltMonitor();
+
+    /*! \brief Sets the tilt angles for the Slope and Lifted events, in
+     * degrees.  The defaults are 5 and 25. */
+    void setAngles(uint8_t slopeDegrees, uint8_t liftDegrees);
+
+    /*! \brief Sets the yaw rate above which the robot is considered to be
+     * spun, in raw gyro units.
+     *
+     * The default, 1286, is 90 degrees per second at +/- 2000 degrees per
+     * second full scale. */
+    void setSpinRate(uint16_t rate)
+    {
+        spinRate = rate;
+    }
+
+    /*! \brief Sets the yaw rate that the motors cause when they run at full
+     * speed in opposite directions, in raw gyro units.
+     *
+     * The default, 18900, is about 1320 degrees per second, which is how fast
+     * a Zumo with 75:1 motors would spin if its tracks did not slip, at
+     * +/- 2000 degrees per second full scale. */
+    void setTurnRate(uint16_t rate)
+    {
+        turnRate = rate;
+    }
+
+    /*! \brief Sets the reading of the gyro's Z axis when the robot is not
+     * turning, which is subtracted from every reading.
+     *
+     * To measure it, average a few hundred readings while the robot is still,
+     * like the TurnSensor.h file from the MazeSolver example does.  The
+     * default is 0. */
+    void setGyroOffset(int16_t offset)
+    {
+        gyroOffset = offset;
+    }
+
+    /*! \brief Forgets the filtered readings and the current state. */
+    void reset();
+
+    /*! \brief Reads the accelerometer and gyro if they have new data and
+     * updates the state.
+     *
+     * This should be called as often as possible, and at least as often as
+     * the IMU makes new readings.
+     *
+     * \return A bitmask of the events (see #Event) that started since the last
+     * call. */
+    uint8_t update(Zumo32U4IMU & imu);
+
+    /*! \brief Adds an accelerometer reading and updates the state.
+     *
+     * Use this and addGyroReading() instead of update() if your code already
+     * reads the IMU.
+     *
+     * \return A bitmask of the events (see #Event) that started. */
+    uint8_t addAccReading(int16_t x, int16_t y, int16_t z);
+
+    /*! \brief Adds a reading of the gyro's Z axis and updates the state.
+     *
+     * \return A bitmask of the events (see #Event) that started. */
+    uint8_t addGyroReading(int16_t z);
+
+    /*! \brief Returns a bitmask of the events (see #Event) that are currently
+     * happening. */
+    uint8_t getState() const
+    {
+        return state;
+    }
+
+    /*! \brief Returns true if the robot is tilted steeply or being picked
+     * up. */
+    bool isLifted() const
+    {
+        return state & Lifted;
+    }
+
+    /*! \brief Returns true if the robot is standing on a slope. */
+    bool isOnSlope() const
+    {
+        return state & Slope;
+    }
+
+    /*! \brief Returns true if something other than the motors is turning the
+     * robot. */
+    bool isBeingSpun() const
+    {
+        return state & Spun;
+    }
+
+    /*! \brief Returns how far the robot is tilted from level, from 0 (level)
+     * to 0x8000 (upside down). */
+    uint16_t getTiltAngle() const
+    {
+        return tiltAngle;
+    }
+
+    /*! \brief Returns the direction that faces uphill.
+     *
+     * For example, 0 means that the front of the robot is higher than the
+     * back, and 0x4000 means that the left side is higher than the right.
+     * This is only meaningful when the robot is tilted. */
+    uint16_t getTiltDirection() const;
+
+    /*! \brief Returns the filtered reading of the gyro's Z axis, minus the
+     * offset.  Positive values are counter-clockwise. */
+    int16_t getYawRate() const
+    {
+        return yawRate;
+    }
+
+private:
+
+    // Replaces the state bits in mask with newBits and returns the bits that
+    // were set.
+    uint8_t setState(uint8_t mask, uint8_t newBits);
+
+    uint16_t slopeAngle;
+    uint16_t liftAngle;
+    uint16_t spinRate;
+    uint16_t turnRate;
+    int16_t gyroOffset;
+
+    bool accStarted;
+    bool gyroStarted;
+    int16_t accX;
+    int16_t accY;
+    int16_t accZ;
+    int16_t yawRate;
+    uint16_t tiltAngle;
+    uint8_t state;
+};
@@ -0,0 +1,50 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Timebase.h>
+#include <Arduino.h>
+#include <avr/io.h>
+
+bool Zumo32U4Timebase::running = false;
+bool Zumo32U4Timebase::suspended = false;
+uint16_t Zumo32U4Timebase::savedTicks;
+uint32_t Zumo32U4Timebase::savedMicros;
+
+void Zumo32U4Timebase::init()
+{
+    if (running) { return; }
+    configureTimer();
+    TCNT3 = 0;
+    running = true;
+}
+
+// Configures Timer 3 to count freely from 0 to 0xFFFF.
+void Zumo32U4Timebase::configureTimer()
+{
+    // Timer 3 configuration
+    // prescaler: clockI/O / 8
+    // outputs disabled
+    // normal mode, top of 0xFFFF
+    // no interrupts
+    //
+    // Tick frequency calculation
+    // 16MHz / 8 (prescaler) = 2 MHz
+    TIMSK3 = 0;
+    TCCR3A = 0;
+    TCCR3B = (1 << CS31);
+}
+
+void Zumo32U4Timebase::suspend()
+{
+    if (!running || suspended) { return; }
+    savedTicks = TCNT3;
+    savedMicros = micros();
+    suspended = true;
+}
+
+void Zumo32U4Timebase::resume()
+{
+    if (!suspended) { return; }
+    configureTimer();
+    TCNT3 = savedTicks + (uint16_t)(micros() - savedMicros) * ticksPerUs;
+    suspended = false;
+}
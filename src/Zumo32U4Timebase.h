@@ -0,0 +1,100 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Timebase.h */
+
+#pragma once
+
+#include <stdint.h>
+#include <avr/io.h>
+
+/*! \brief Provides a fast, high-resolution time measurement using Timer 3.
+ *
+ * The Arduino `micros()` function has a resolution of 4 microseconds and
+ * takes several microseconds to run because it has to combine a hardware
+ * counter with a software overflow count while interrupts are disabled.  This
+ * class instead runs Timer 3 freely at 2 MHz, so that ticks() can return a
+ * 16-bit time stamp with a resolution of 0.5 microseconds by reading a single
+ * register.  Since the count is only 16 bits, it wraps around every
+ * 32.768 milliseconds, so it is only suitable for measuring intervals shorter
+ * than that.  The difference between two readings should be computed with
+ * unsigned 16-bit arithmetic so that it is correct even if the count wrapped
+ * around in between:
+ *
+ * ~~~{.cpp}
+ * uint16_t start = Zumo32U4Timebase::ticks();
+ * // ...
+ * uint16_t elapsedTicks = Zumo32U4Timebase::ticks() - start;
+ * ~~~
+ *
+ * You must call init() before using ticks(), usually in `setup()`.
+ *
+ * Timer 3 conflicts
+ * ====
+ *
+ * Because this class uses Timer 3, it conflicts with `analogWrite()` on pin 5
+ * and with other libraries that use Timer 3.
+ *
+ * Zumo32U4IRPulses, which is used by Zumo32U4ProximitySensors::read(), needs
+ * Timer 3 while it is emitting pulses.  When the pulses stop,
+ * Zumo32U4IRPulses::stop() restarts the time base and advances the count by
+ * the time that passed, as measured with `micros()`.  Intervals that include
+ * IR pulses are therefore only accurate to within a few microseconds per
+ * burst of pulses. */
+class Zumo32U4Timebase
+{
+public:
+
+    /*! The number of ticks per microsecond. */
+    static const uint8_t ticksPerUs = 2;
+
+    /*! \brief Starts Timer 3 running freely at 2 MHz.
+     *
+     * This function must be called before ticks().  It is safe to call it more
+     * than once. */
+    static void init();
+
+    /*! \brief Returns true if init() has been called. */
+    static bool isRunning()
+    {
+        return running;
+    }
+
+    /*! \brief Returns the current time in units of 0.5 microseconds.
+     *
+     * This function takes a few CPU cycles to run.  If code in an interrupt
+     * service routine accesses 16-bit Timer 3 registers, you should disable
+     * interrupts while calling this function. */
+    static inline uint16_t ticks()
+    {
+        return TCNT3;
+    }
+
+    /*! \brief Converts a number of ticks to microseconds. */
+    static inline uint16_t ticksToUs(uint16_t ticks)
+    {
+        return ticks / ticksPerUs;
+    }
+
+    /*! \brief Saves the current count before another class takes over
+     * Timer 3.
+     *
+     * This is called by Zumo32U4IRPulses::start(), so you should not normally
+     * need to call it. */
+    static void suspend();
+
+    /*! \brief Restarts the time base after another class is done using
+     * Timer 3, if it was running before suspend() was called.
+     *
+     * This is called by Zumo32U4IRPulses::stop(), so you should not normally
+     * need to call it. */
+    static void resume();
+
+private:
+
+    static void configureTimer();
+
+    static bool running;
+    static bool suspended;
+    static uint16_t savedTicks;
+    static uint32_t savedMicros;
+};
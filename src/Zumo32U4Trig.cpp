@@ -0,0 +1,118 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+#include <Zumo32U4Trig.h>
+#include <avr/pgmspace.h>
+
+// sin(i * 90 / 256 degrees) * 16384, rounded, for i from 0 to 256.
+static const int16_t sineTable[257] PROGMEM = {
+    0, 101, 201, 302, 402, 503, 603, 704,
+    804, 904, 1005, 1105, 1205, 1306, 1406, 1506,
+    1606, 1706, 1806, 1906, 2006, 2105, 2205, 2305,
+    2404, 2503, 2603, 2702, 2801, 2900, 2999, 3098,
+    3196, 3295, 3393, 3492, 3590, 3688, 3786, 3883,
+    3981, 4078, 4176, 4273, 4370, 4467, 4563, 4660,
+    4756, 4852, 4948, 5044, 5139, 5235, 5330, 5425,
+    5520, 5614, 5708, 5803, 5897, 5990, 6084, 6177,
+    6270, 6363, 6455, 6547, 6639, 6731, 6823, 6914,
+    7005, 7096, 7186, 7276, 7366, 7456, 7545, 7635,
+    7723, 7812, 7900, 7988, 8076, 8163, 8250, 8337,
+    8423, 8509, 8595, 8680, 8765, 8850, 8935, 9019,
+    9102, 9186, 9269, 9352, 9434, 9516, 9598, 9679,
+    9760, 9841, 9921, 10001, 10080, 10159, 10238, 10316,
+    10394, 10471, 10549, 10625, 10702, 10778, 10853, 10928,
+    11003, 11077, 11151, 11224, 11297, 11370, 11442, 11514,
+    11585, 11656, 11727, 11797, 11866, 11935, 12004, 12072,
+    12140, 12207, 12274, 12340, 12406, 12472, 12537, 12601,
+    12665, 12729, 12792, 12854, 12916, 12978, 13039, 13100,
+    13160, 13219, 13279, 13337, 13395, 13453, 13510, 13567,
+    13623, 13678, 13733, 13788, 13842, 13896, 13949, 14001,
+    14053, 14104, 14155, 14206, 14256, 14305, 14354, 14402,
+    14449, 14497, 14543, 14589, 14635, 14680, 14724, 14768,
+    14811, 14854, 14896, 14937, 14978, 15019, 15059, 15098,
+    15137, 15175, 15213, 15250, 15286, 15322, 15357, 15392,
+    15426, 15460, 15493, 15525, 15557, 15588, 15619, 15649,
+    15679, 15707, 15736, 15763, 15791, 15817, 15843, 15868,
+    15893, 15917, 15941, 15964, 15986, 16008, 16029, 16049,
+    16069, 16088, 16107, 16125, 16143, 16160, 16176, 16192,
+    16207, 16221, 16235, 16248, 16261, 16273, 16284, 16295,
+    16305, 16315, 16324, 16332, 16340, 16347, 16353, 16359,
+    16364, 16369, 16373, 16376, 16379, 16381, 16383, 16384,
+    16384
+};
+
+int16_t Zumo32U4Trig::sine(uint16_t angle)
+{
+    // Use the symmetry of the sine wave to find the angle within the first
+    // quarter.
+    uint16_t x = angle & 0x3FFF;
+    if (angle & 0x4000) { x = 0x4000 - x; }
+
+    // Interpolate between the two nearest table entries.  The top 8 bits of
+    // x are the index and the bottom 6 bits are the fraction.
+    uint16_t index = x >> 6;
+    uint8_t fraction = x & 63;
+    int16_t result = pgm_read_word(&sineTable[index]);
+    if (fraction)
+    {
+        int16_t next = pgm_read_word(&sineTable[index + 1]);
+        result += ((next - result) * fraction + 32) >> 6;
+    }
+
+    if (angle & 0x8000) { result = -result; }
+    return result;
+}
+
+// Returns atan(r) for r from 0 to 1, where r has 15 fractional bits.  This
+// uses the approximation atan(r) = pi/4 r + r (1 - r) (0.2447 + 0.0663 r)
+// with the angle scaled so that 65536 is a full turn.
+static uint16_t arctangentOfRatio(uint16_t r)
+{
+    uint32_t t = (uint32_t)r * (32768 - r) >> 15;
+    uint32_t c = 2552 + ((uint32_t)692 * r >> 15);
+    return ((uint32_t)r >> 2) + (t * c >> 15);
+}
+
+uint16_t Zumo32U4Trig::arctangent(int16_t y, int16_t x)
+{
+    uint16_t ax = x < 0 ? -x : x;
+    uint16_t ay = y < 0 ? -y : y;
+    if (ax == 0 && ay == 0) { return 0; }
+
+    // Find the angle within the first octant, then use symmetry to find the
+    // angle in the right octant.
+    uint16_t angle;
+    if (ay <= ax)
+    {
+        angle = arctangentOfRatio(((uint32_t)ay << 15) / ax);
+    }
+    else
+    {
+        angle = 0x4000 - arctangentOfRatio(((uint32_t)ax << 15) / ay);
+    }
+
+    if (x < 0) { angle = 0x8000 - angle; }
+    if (y < 0) { angle = -angle; }
+    return angle;
+}
+
+uint16_t Zumo32U4Trig::squareRoot(uint32_t square)
+{
+    // Find the result one bit at a time.
+    uint32_t result = 0;
+    uint32_t bit = (uint32_t)1 << 30;
+    while (bit > square) { bit >>= 2; }
+    while (bit)
+    {
+        if (square >= result + bit)
+        {
+            square -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
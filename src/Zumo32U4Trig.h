@@ -0,0 +1,58 @@
+// Copyright Pololu Corporation.  For more information, see http://www.pololu.com/
+
+/*! \file Zumo32U4Trig.h */
+
+#pragma once
+
+#include <stdint.h>
+
+/*! \brief Integer trigonometry functions.
+ *
+ * The floating-point `sin()`, `cos()`, and `atan2()` functions take hundreds
+ * of microseconds on the ATmega32U4.  sine() and cosine() look the result up
+ * in a 257-entry table of the first quarter of the sine wave, which is stored
+ * in program memory, and interpolate between entries, so they take a few
+ * microseconds and use no RAM.  arctangent() uses a polynomial instead.
+ *
+ * Angles are 16-bit unsigned numbers where 65536 represents 360 degrees, so
+ * 0x4000 is 90 degrees and 0x8000 is 180 degrees.  This is the same as the
+ * upper 16 bits of the 32-bit angles used by the TurnSensor.h file in the
+ * MazeSolver example, where 0x20000000 represents 45 degrees.  Angles wrap
+ * around naturally, so `(uint16_t)-0x4000` is -90 degrees.
+ *
+ * The results have 14 fractional bits: 16384 represents 1. */
+class Zumo32U4Trig
+{
+public:
+
+    /*! The value that represents 1 in the results. */
+    static const int16_t one = 16384;
+
+    /*! \brief Returns the sine of an angle, from -16384 to 16384.
+     *
+     * The error is at most 1. */
+    static int16_t sine(uint16_t angle);
+
+    /*! \brief Returns the cosine of an angle, from -16384 to 16384. */
+    static int16_t cosine(uint16_t angle)
+    {
+        return sine(angle + 0x4000);
+    }
+
+    /*! \brief Returns the angle of the vector (x, y), like `atan2(y, x)`.
+     *
+     * For example, arctangent(1, 0) is 0x4000 (90 degrees) and
+     * arctangent(0, -1) is 0x8000 (180 degrees).  The error is at most about
+     * 0.1 degrees.  If both arguments are 0, the result is 0. */
+    static uint16_t arctangent(int16_t y, int16_t x);
+
+    /*! \brief Returns the length of the vector (x, y), rounded down. */
+    static uint16_t magnitude(int16_t x, int16_t y)
+    {
+        return squareRoot((uint32_t)((int32_t)x * x) +
+            (uint32_t)((int32_t)y * y));
+    }
+
+    /*! \brief Returns the square root of a number, rounded down. */
+    static uint16_t squareRoot(uint32_t square);
+};